@@ -1,79 +1,5 @@
-vec3 hash3(vec3 p)
-{
-    mat3 seed = mat3(742.342, 823.457, 242.086,
-                     247.999, 530.343, 634.112,
-                     437.652, 139.485, 484.348);
-
-    return fract(seed * sin(p)) * 2.0 - vec3(1.0);
-}
-
-
-float noise3(vec3 p)
-{
-    float f = (sqrt(4.0) - 1.0) / 3.0;
-    mat3 skew = mat3(1.0 + f, f, f,
-                     f, 1.0 + f, f,
-					 f, f, 1.0 + f);
-    float g = (1.0 - 1.0/sqrt(4.0)) / 3.0;
-    mat3 invskew = mat3(1.0-g, -g, -g,
-                        -g, 1.0-g, -g,
-						-g, -g, 1.0-g);
-
-    vec3 sp = skew * p;
-    vec3 cell = floor(sp);
-    vec3 d0 = fract(sp);
-
-    float x0 = step(d0.x, d0.y);
-	float x1 = step(d0.y, d0.z);
-	float x2 = step(d0.z, d0.x);
-    vec3 s0 = vec3(x2*(1.-x0), x0*(1.-x1), x1*(1.-x2));
-    vec3 s1 = min(vec3(1.0), vec3(1.0) + vec3(x2-x0, x0-x1, x1-x2));
-
-    vec3 sv[4] = vec3[4](cell,
-                         cell + s0,
-                         cell + s1,
-                         cell + vec3(1.0));
-    vec3 wv[4] = vec3[4](invskew * sv[0],
-                         invskew * sv[1],
-                         invskew * sv[2],
-                         invskew * sv[3]);
-    vec3 d[4] = vec3[4](p - wv[0],
-                        p - wv[1],
-                        p - wv[2],
-                        p - wv[3]);
-
-    vec4 weights = max(vec4(0.0), vec4(0.6) - vec4(dot(d[0], d[0]),
-                                                   dot(d[1], d[1]),
-                                                   dot(d[2], d[2]),
-                                                   dot(d[3], d[3])));
-    weights = weights * weights * weights * weights;
-
-    return (dot(hash3(sv[0]), d[0]) * weights[0] +
-            dot(hash3(sv[1]), d[1]) * weights[1] +
-            dot(hash3(sv[2]), d[2]) * weights[2] +
-            dot(hash3(sv[3]), d[3]) * weights[3]) * 16.0;
-}
-
-vec3 target_half_diagonal_hfov(float n, float alpha, float aspect)
-{
-	float half_width = tan(alpha * 0.5) * n;
-	float half_height = half_width * aspect;
-	return vec3(half_width, half_height, n);
-}
-
-vec3 target_half_diagonal_vfov(float n, float alpha, float aspect)
-{
-	float half_height = tan(alpha * 0.5) * n;
-	float half_width = half_height * aspect;
-	return vec3(half_width, half_height, n);
-}
-
-
-vec3 compute_ray_plane(vec3 half_diagonal, vec2 clip_coord)
-{
-	vec3 target = half_diagonal * vec3(clip_coord, 1.0);
-	return normalize(target);
-}
+#include "include/noise3.glsl"
+#include "include/camera.glsl"
 
 float scene(vec3 p)
 {
@@ -123,18 +123,43 @@ vec3 scene_color(vec3 p)
 	return vec3(0.4, 0.8, 0.5) * 1.0;
 }
 
+vec3 primary_ray(vec2 frag_coord)
+{
+	vec2 clip_coord = ((frag_coord / iResolution) - 0.5) * 2.0;
+	vec3 ray = compute_ray_matrix(iInvProjMat, clip_coord);
+    return rotateX(-sin(iTime) * PI / 64) * ray;
+}
+
+#pragma sr_pass prepass
+
+// Marches a cone wrapping the rays of the whole tile, stops as soon as the
+// scene gets closer than the cone radius.
 void imageMain(inout vec4 frag_color, vec2 frag_coord)
 {
-	float aspect_ratio = iResolution.y / iResolution.x;
-	float fov = 60.0 * PI / 180.0;
+	vec3 ray = primary_ray(frag_coord);
+	float half_tile = 0.5 * iPrepassTileSize;
+	vec3 corner_ray = primary_ray(frag_coord + vec2(half_tile));
+	float cone_slope = length(corner_ray / dot(corner_ray, ray) - ray);
 
-	float near = 0.1;
-	vec3 half_diagonal = target_half_diagonal_hfov(near, fov, aspect_ratio);
-	vec2 clip_coord = ((frag_coord / iResolution) - 0.5) * 2.0;
-	vec3 ray = compute_ray_matrix(inverse(iProjMat), clip_coord);
-    ray = rotateX(-sin(iTime) * PI / 64) * ray;
+	float t = 0.0;
+	for (int rm_step = 0; rm_step < kMaxStep; rm_step++)
+	{
+		float rm_dist = scene(ray * t);
+		float radius = t * cone_slope;
+		if (rm_dist < radius)
+			break;
+		t += (rm_dist - radius) / (1.0 + cone_slope);
+	}
+	frag_color = vec4(t);
+}
+
+#pragma sr_pass image
+
+void imageMain(inout vec4 frag_color, vec2 frag_coord)
+{
+	vec3 ray = primary_ray(frag_coord);
 
-	vec3 position = vec3(0.0, 0.0, 0.0);//sin(iTime * 0.2), cos(iTime * 0.2), -5.0);
+	vec3 position = ray * srPrepassStart(frag_coord);//sin(iTime * 0.2), cos(iTime * 0.2), -5.0);
     vec3 start_pos = position;
 	float rm_dist = scene(position);
     float min_dist = 1.0/0.0;
@@ -0,0 +1,28 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+vec2 DotPosition(float t) {
+	return vec2(0.5) + 0.3 * vec2(cos(t), sin(2.0 * t));
+}
+
+#pragma sr_pass buffer0
+// Trail, the previous frame of the pass fades out under the moving dot.
+void imageMain(inout vec4 frag_color, vec2 frag_coord) {
+	vec2 uv = frag_coord / iResolution;
+	float dot_mask = smoothstep(0.03, 0.02, length(uv - DotPosition(iTime)));
+	vec4 previous = texture(iChannel0, uv);
+	frag_color = max(previous * 0.97, vec4(dot_mask));
+}
+
+#pragma sr_pass image
+void imageMain(inout vec4 frag_color, vec2 frag_coord) {
+	vec2 uv = frag_coord / iResolution;
+	float trail = texture(iChannel0, uv).r;
+	frag_color = vec4(trail * vec3(1.0, 0.6, 0.2), 1.0);
+}
@@ -0,0 +1,20 @@
+vec3 target_half_diagonal_hfov(float n, float alpha, float aspect)
+{
+	float half_width = tan(alpha * 0.5) * n;
+	float half_height = half_width * aspect;
+	return vec3(half_width, half_height, n);
+}
+
+vec3 target_half_diagonal_vfov(float n, float alpha, float aspect)
+{
+	float half_height = tan(alpha * 0.5) * n;
+	float half_width = half_height * aspect;
+	return vec3(half_width, half_height, n);
+}
+
+
+vec3 compute_ray_plane(vec3 half_diagonal, vec2 clip_coord)
+{
+	vec3 target = half_diagonal * vec3(clip_coord, 1.0);
+	return normalize(target);
+}
@@ -119,9 +119,9 @@ const float kStepMultiplier = 1.0;
 void imageMain(inout vec4 frag_color, vec2 frag_coord)
 {
 	vec2 clip_coord = ((frag_coord / iResolution) - 0.5) * 2.0;
-    vec3 ray = compute_ray_matrix(inverse(iProjMat), clip_coord);
+    vec3 ray = compute_ray_matrix(iInvProjMat, clip_coord);
 
-    vec4 origin = inverse(iProjMat) * vec4(0.0, 0.0, -1.0, 1.0);
+    vec4 origin = iInvProjMat * vec4(0.0, 0.0, -1.0, 1.0);
 	vec3 position = origin.xyz / origin.w;
 	float rm_dist = scene(position);
 
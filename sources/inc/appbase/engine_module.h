@@ -0,0 +1,70 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. You can do whatever you want with this
+ * stuff. If we meet some day, and you think this stuff is worth it, you can
+ * buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_ENGINE_MODULE_HPP__
+#define __YS_ENGINE_MODULE_HPP__
+
+#include <memory>
+#include <string>
+
+#include "shaderunner/shaderunner.h"
+#include "utility/callback.h"
+#include "utility/file_watcher.h"
+
+namespace appbase {
+
+// Shaderunner engine loaded from the sr module through its C API. The module
+// file is watched, once rebuilt a copy of it is loaded and a new context
+// takes over from the old one with the same kernel files, uniforms and
+// resolution. The GL context belongs to the host and outlives the swap,
+// the programs of the new context come back from the program binary cache.
+class EngineModule
+{
+public:
+    static constexpr float kDefaultReloadDebounce = 0.5f;
+public:
+    explicit EngineModule(std::string const &_module_path,
+                          float _reload_debounce = kDefaultReloadDebounce);
+    ~EngineModule();
+    EngineModule(EngineModule const&) = delete;
+    EngineModule& operator=(EngineModule const&) = delete;
+
+    bool loaded() const;
+    // Non blocking, swaps the engine when the module was rebuilt.
+    void Poll();
+
+    bool RenderFrame(FrameDesc const *_desc);
+    int RenderFrames(FrameDesc const *_descs, float const *_times, int _count, void *o_pixels);
+    void WatchKernelFile(sr::ShaderStage _stage, char const *_path);
+    void WaitKernelsBuild();
+    std::string GetKernelPath(sr::ShaderStage _stage) const;
+    // Handles are kept across swaps.
+    int ResolveUniform(char const *_name);
+    void SetUniformValue(int _handle, float _value);
+    void SetResolution(int _width, int _height);
+    float GetGPUFrameTime() const;
+
+    utility::Callback<> onModuleReloaded;
+private:
+    struct Module;
+    static std::unique_ptr<Module> Load(std::string const &_module_path);
+    void Swap(std::unique_ptr<Module> &&_module);
+
+    std::string module_path_;
+    utility::FileWatcher module_watcher_;
+    bool module_changed_;
+    std::unique_ptr<Module> module_;
+    void* context_;
+    int resolution_[2];
+};
+
+} // namespace appbase
+
+#endif // __YS_ENGINE_MODULE_HPP__
@@ -18,6 +18,15 @@
 
 namespace appbase {
 
+// GPU time of each LayerMediator pass, in seconds.
+struct FrameTimings
+{
+    float shaderunner = 0.f;
+    float gizmo = 0.f;
+    float blit = 0.f;
+    float imgui = 0.f;
+};
+
 struct ImGuiLayer
 {
     ImGuiLayer();
@@ -33,8 +42,21 @@ struct ImGuiLayer
     utility::Query<std::string> FKernelPath_query;
     utility::Callback<std::string const&> FKernelPath_onReturn;
 
-    utility::Query<sr::UniformContainer> Uniforms_query;
-    utility::Callback<sr::UniformContainer const&> Uniforms_onReturn;
+    // sr::UniformType of the uniforms added with "+".
+    int new_uniform_type = 0;
+    utility::Query<sr::UniformStore> Uniforms_query;
+    utility::Callback<sr::UniformStore const&> Uniforms_onReturn;
+
+    utility::Query<float> ResolutionScale_query;
+    utility::Query<int> AccumulatedSamples_query;
+    utility::Query<int> FrozenUniforms_query;
+
+    utility::Query<FrameTimings> FrameTimings_query;
+    utility::Query<sr::CostStats> CostStats_query;
+
+    // Kernel paths, along with whether they are ready to switch to.
+    utility::Query<std::vector<std::pair<std::string, bool>>> Playlist_query;
+    utility::Callback<int> Playlist_onSelect;
 
     std::string error_console_buffer;
     void onFKernelCompileFinished(std::string const&_path, sr::ErrorLogContainer const&_errorlog);
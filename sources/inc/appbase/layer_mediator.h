@@ -15,6 +15,7 @@
 #include <memory>
 
 #include "oglbase/framebuffer.h"
+#include "oglbase/timer.h"
 #include "shaderunner/shaderunner.h"
 #include "uibase/gizmo_layer.h"
 #include "appbase/state.h"
@@ -41,6 +42,9 @@ struct LayerMediator
     void MouseDelta(uibase::Vec2i_t const& _delta);
     void KeyDown(std::uint32_t _key, std::uint32_t _mod, bool _v);
     bool RunFrame(float _dt);
+    // False while the last frame is still up to date, hosts rendering on
+    // demand then only need to render on input events.
+    bool NeedsFrame() const;
 
     State state_;
     State back_state_;
@@ -49,6 +53,12 @@ struct LayerMediator
     std::unique_ptr<uibase::GizmoLayer> gizmo_layer_;
     std::unique_ptr<appbase::ImGuiLayer> imgui_layer_;
     std::unique_ptr<oglbase::Framebuffer> framebuffer_;
+
+    oglbase::GPUTimer shaderunner_timer_;
+    oglbase::GPUTimer gizmo_timer_;
+    oglbase::GPUTimer blit_timer_;
+    oglbase::GPUTimer imgui_timer_;
+    FrameTimings timings_;
 };
 
 } // namespace appbase
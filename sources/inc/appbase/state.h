@@ -60,6 +60,24 @@ struct State {
     std::array<eKey, 256> key_map;
 
     bool enable_gizmos = false;
+
+    bool progressive_rendering = false;
+    float progressive_budget_ms = 16.f;
+
+    bool dynamic_resolution = false;
+    float dynamic_resolution_target_ms = 16.f;
+    bool dynamic_resolution_linear = true;
+
+    bool accumulate_samples = false;
+    bool compute_execution = false;
+    bool compute_morton_order = true;
+    bool temporal_ray_reuse = false;
+    bool depth_prepass = true;
+    bool cost_heatmap = false;
+    float cost_heatmap_opacity = 0.75f;
+    bool freeze_uniforms = false;
+    bool render_on_demand = true;
+    float playlist_crossfade_s = 1.f;
     std::uint32_t hover_gizmo = 0u;
     std::uint32_t select_gizmo = 0u;
 
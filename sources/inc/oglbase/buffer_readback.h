@@ -0,0 +1,60 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_OGL_BUFFER_READBACK_HPP__
+#define __YS_OGL_BUFFER_READBACK_HPP__
+
+#include <array>
+#include <cstddef>
+
+#include <GL/glew.h>
+
+#include "oglbase/handle.h"
+
+namespace oglbase {
+
+
+// Reads buffer content back without waiting on the GPU. Captures are copied
+// aside on the GPU into a small ring and fenced, a copy is only read once its
+// fence has signaled, the result therefore lags a few frames behind. When the
+// ring is full the oldest copy not read yet is dropped.
+class BufferReadback
+{
+public:
+	static constexpr std::size_t kRingSize = 3u;
+
+	BufferReadback();
+	~BufferReadback();
+	BufferReadback(BufferReadback const&) = delete;
+	BufferReadback& operator=(BufferReadback const&) = delete;
+
+	// Copies the first _size bytes of _buffer.
+	void Capture(GLuint _buffer, GLsizeiptr _size);
+	// Most recent copy ready since the last Read, up to _capacity bytes of it
+	// go to o_data. Returns the copy size, 0 when none is ready.
+	GLsizeiptr Read(void *o_data, GLsizeiptr _capacity);
+	// Drops the copies not read yet.
+	void Reset();
+private:
+	struct Slot
+	{
+		BufferPtr buffer;
+		GLsizeiptr capacity;
+		GLsizeiptr size;
+		GLsync fence;
+	};
+	std::array<Slot, kRingSize> ring_;
+	std::size_t head_;
+};
+
+
+} // namespace oglbase
+
+#endif // __YS_OGL_BUFFER_READBACK_HPP__
@@ -36,6 +36,7 @@ struct Framebuffer
 
     void Bind() const;
     void Unbind() const;
+    GLuint texture(std::size_t _attachment) const { return buffers_[_attachment]; }
 
     FBOPtr fbo_;
 
@@ -41,6 +41,7 @@ struct TextureDeleter;
 struct VAODeleter;
 struct BufferDeleter;
 struct FBODeleter;
+struct QueryDeleter;
 
 using ProgramPtr = Handle<ProgramDeleter>;
 using ShaderPtr = Handle<ShaderDeleter>;
@@ -48,6 +49,7 @@ using TexturePtr = Handle<TextureDeleter>;
 using VAOPtr = Handle<VAODeleter>;
 using BufferPtr = Handle<BufferDeleter>;
 using FBOPtr = Handle<FBODeleter>;
+using QueryPtr = Handle<QueryDeleter>;
 
 } // namespace oglbase
 
@@ -0,0 +1,87 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_OGL_PROGRAM_BINARY_HPP__
+#define __YS_OGL_PROGRAM_BINARY_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "oglbase/handle.h"
+
+namespace oglbase {
+
+
+// Marks a program as being built by one context, released on destruction.
+// A claim that doesn't own its key evaluates to false.
+class ProgramBuildClaim
+{
+public:
+	ProgramBuildClaim() = default;
+	ProgramBuildClaim(ProgramBuildClaim &&_other);
+	ProgramBuildClaim& operator=(ProgramBuildClaim &&_other);
+	~ProgramBuildClaim();
+	ProgramBuildClaim(ProgramBuildClaim const&) = delete;
+	ProgramBuildClaim& operator=(ProgramBuildClaim const&) = delete;
+
+	explicit operator bool() const { return owned_; }
+private:
+	friend class ProgramBinaryCache;
+	ProgramBuildClaim(std::uint64_t _key, bool _owned, bool _registered);
+	void Release();
+
+	std::uint64_t key_ = 0u;
+	bool owned_ = false;
+	bool registered_ = false;
+};
+
+
+// glGetProgramBinary/glProgramBinary store. Binaries are kept in memory for
+// the whole process, so that every cache instance (every render context, in
+// any share group, on any thread) gets the programs linked by the others, and
+// are persisted one file per key when a directory is given. The in-memory
+// binaries are bounded by kSharedMemoryBudget bytes, the least recently used
+// go first and are then only found on disk, if persisted.
+// Keys are provided by the caller (typically a hash of the program sources),
+// the driver identification strings are mixed in so that a driver update
+// invalidates every entry and contexts of different drivers never exchange
+// binaries.
+class ProgramBinaryCache
+{
+public:
+	static constexpr std::size_t kSharedMemoryBudget = 32u << 20u;
+
+	explicit ProgramBinaryCache(std::string const &_directory);
+	bool enabled() const { return enabled_; }
+
+	ProgramPtr Load(std::uint64_t _key) const;
+	void Store(std::uint64_t _key, GLuint _program) const;
+
+	// Claims the build of _key, the returned claim is false while another
+	// context holds it: that context will Store the program shortly, or give
+	// up on it once Claimed returns false.
+	ProgramBuildClaim Claim(std::uint64_t _key) const;
+	bool Claimed(std::uint64_t _key) const;
+private:
+	std::string EntryPath(std::uint64_t _key) const;
+
+	std::string directory_;
+	std::uint64_t driver_hash_;
+	bool enabled_;
+	bool persistent_;
+};
+
+
+} // namespace oglbase
+
+#endif // __YS_OGL_PROGRAM_BINARY_HPP__
@@ -26,7 +26,22 @@ using ShaderBinaries_t = std::vector<GLuint>;
 
 ShaderPtr CompileShader(GLenum _type, ShaderSources_t const&_sources, std::string *o_log = nullptr);
 
-ProgramPtr LinkProgram(ShaderBinaries_t const &_binaries);
+// _retrievable_binary sets GL_PROGRAM_BINARY_RETRIEVABLE_HINT before linking.
+ProgramPtr LinkProgram(ShaderBinaries_t const &_binaries, bool _retrievable_binary = false);
+
+// Split compile and link entry points, for callers that don't want to block on
+// the driver. Begin* only issue the work, Is*Ready polls GL_COMPLETION_STATUS_KHR
+// when KHR_parallel_shader_compile is available (and otherwise reports ready, so
+// that End* blocks instead), End* checks the status and resets the handle on failure.
+void EnableParallelShaderCompile();
+
+ShaderPtr BeginCompileShader(GLenum _type, ShaderSources_t const&_sources);
+bool IsShaderReady(GLuint _shader);
+bool EndCompileShader(ShaderPtr &_shader, std::string *o_log = nullptr);
+
+ProgramPtr BeginLinkProgram(ShaderBinaries_t const &_binaries, bool _retrievable_binary = false);
+bool IsProgramReady(GLuint _program);
+bool EndLinkProgram(ProgramPtr &_program, std::string *o_log = nullptr);
 
 } // namespace oglbase
 
@@ -0,0 +1,58 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_OGL_STREAM_BUFFER_HPP__
+#define __YS_OGL_STREAM_BUFFER_HPP__
+
+#include <array>
+#include <cstddef>
+
+#include <GL/glew.h>
+
+#include "oglbase/handle.h"
+
+namespace oglbase {
+
+
+// Persistently mapped buffer split in kRegionCount regions, each write goes
+// to the next region. Fence() guards the current region once the commands
+// reading it are issued, a write only waits when it wraps around to a
+// region the GPU may still be reading. The storage grows on demand.
+class StreamBuffer
+{
+public:
+	static constexpr std::size_t kRegionCount = 3u;
+
+	StreamBuffer();
+	StreamBuffer(StreamBuffer const&) = delete;
+	StreamBuffer& operator=(StreamBuffer const&) = delete;
+	~StreamBuffer();
+
+	// Moves to the next region, returns where to write _size bytes.
+	void* Write(std::size_t _size);
+	void Fence();
+
+	GLuint buffer() const { return buffer_; }
+	GLintptr offset() const { return static_cast<GLintptr>(region_ * region_size_); }
+private:
+	void Allocate(std::size_t _region_size);
+	void ClearFences();
+
+	BufferPtr buffer_;
+	void* mapping_;
+	std::size_t region_size_;
+	std::size_t region_;
+	std::array<GLsync, kRegionCount> fences_;
+};
+
+
+} // namespace oglbase
+
+#endif // __YS_OGL_STREAM_BUFFER_HPP__
@@ -0,0 +1,68 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_OGL_TIMER_HPP__
+#define __YS_OGL_TIMER_HPP__
+
+#include <array>
+#include <cstddef>
+
+#include <GL/glew.h>
+
+#include "oglbase/handle.h"
+
+namespace oglbase {
+
+
+// GPU time spent between Begin() and End(), measured with a pair of
+// GL_TIMESTAMP queries so that timers can be nested. Samples go through a
+// small ring and are only read once the driver reports them available, the
+// result therefore lags a few frames behind. When the ring is full the
+// sample is dropped rather than waiting on the GPU.
+class GPUTimer
+{
+public:
+	static constexpr std::size_t kRingSize = 4u;
+
+	GPUTimer();
+	GPUTimer(GPUTimer const&) = delete;
+	GPUTimer& operator=(GPUTimer const&) = delete;
+
+	void Begin();
+	// _count splits the sample between that many equal units of work,
+	// elapsed() then reports the time of one.
+	void End(int _count = 1);
+
+	// Most recent available measurement in seconds, 0 until one is.
+	float elapsed() const { return elapsed_; }
+	// Measurements collected so far, tells a new elapsed() from a repeated one.
+	std::size_t sample_count() const { return sample_count_; }
+private:
+	void Collect();
+
+	struct Sample
+	{
+		QueryPtr start;
+		QueryPtr end;
+		int count;
+		bool pending;
+	};
+	std::array<Sample, kRingSize> ring_;
+	std::size_t head_;
+	std::size_t tail_;
+	bool recording_;
+	float elapsed_;
+	std::size_t sample_count_;
+};
+
+
+} // namespace oglbase
+
+#endif // __YS_OGL_TIMER_HPP__
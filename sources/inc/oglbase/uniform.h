@@ -0,0 +1,39 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_OGL_UNIFORM_HPP__
+#define __YS_OGL_UNIFORM_HPP__
+
+#include <string>
+#include <unordered_map>
+
+#include <GL/glew.h>
+
+namespace oglbase {
+
+
+struct UniformDesc
+{
+	GLint location;
+	GLenum type;
+	GLint size;
+};
+
+// Keyed by uniform name, array uniforms are stored without their "[0]" suffix.
+using UniformTable_t = std::unordered_map<std::string, UniformDesc>;
+
+// Only default block uniforms are reflected, block members have no location.
+UniformTable_t ReflectUniforms(GLuint _program);
+
+GLint FindUniform(UniformTable_t const &_table, char const *_name);
+
+} // namespace oglbase
+
+#endif // __YS_OGL_UNIFORM_HPP__
@@ -0,0 +1,99 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_KERNEL_PREPROCESSOR_HPP__
+#define __YS_KERNEL_PREPROCESSOR_HPP__
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shaderunner/shaderunner.h"
+
+#include "utility/hash.h"
+
+namespace sr {
+
+
+// Kernel with its #include directives expanded.
+struct PreprocessedKernel
+{
+	// Origin of an expanded line. Lines pulled from an include are also
+	// attributed to the #include line of the kernel file they come through.
+	struct Line
+	{
+		int file;
+		int line;
+		int kernel_line;
+	};
+
+	std::string source;
+	// files[0] is the kernel file itself, followed by every included file.
+	std::vector<std::string> files;
+	std::vector<Line> line_map;
+	// Unresolved includes, at the line of the kernel file.
+	ErrorLogContainer errors;
+
+	// Points _errorlog lines at the kernel file, messages about an included
+	// file are prefixed with its path and line.
+	void RemapErrorLog(ErrorLogContainer &_errorlog) const;
+};
+
+
+// Resolves #include "file" against the directory of the including file then
+// the search paths, #include <file> against the search paths only. A file is
+// only expanded once per kernel, later includes of it (recursive ones too) are
+// left blank.
+// Included files are kept parsed until Refresh reports a content change.
+class KernelPreprocessor
+{
+public:
+	KernelPreprocessor() = default;
+public:
+	void AddSearchPath(std::string const &_path);
+	PreprocessedKernel Process(std::string const &_path, std::string const &_source);
+
+	// Re-reads an included file, returns false when its content hash didn't
+	// change so that kernels including it don't have to be rebuilt.
+	bool Refresh(std::string const &_path);
+	// Files directly or indirectly including _path.
+	std::set<std::string> Dependents(std::string const &_path) const;
+private:
+	struct Include
+	{
+		std::size_t line;
+		std::string name;
+		std::string path;
+	};
+
+	struct ParsedFile
+	{
+		utility::Hash_t content_hash;
+		std::vector<std::string> lines;
+		std::vector<Include> includes;
+	};
+
+	static bool ParseInclude(std::string const &_line, std::string *o_name, bool *o_angled);
+	ParsedFile Parse(std::string const &_path, std::string const &_source) const;
+	std::string Resolve(std::string const &_including_path, std::string const &_name, bool _angled) const;
+	ParsedFile const *Load(std::string const &_path);
+	void Expand(ParsedFile const &_file, int _file_index, int _kernel_line,
+	            PreprocessedKernel &_result);
+
+	std::vector<std::string> search_paths_;
+	std::unordered_map<std::string, ParsedFile> files_;
+};
+
+
+} // namespace sr
+
+
+#endif // __YS_KERNEL_PREPROCESSOR_HPP__
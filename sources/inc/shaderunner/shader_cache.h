@@ -12,24 +12,38 @@
 #define __YS_SHADER_CACHE_HPP__
 
 #include <array>
+#include <list>
 #include <set>
+#include <unordered_map>
 
 #include <GL/glew.h>
 
 #include "oglbase/shader.h"
 
+#include "utility/hash.h"
+
 namespace sr {
 
 
-enum class ShaderStage { kVertex = 0, kFragment, kGeometry, kCount };
+// kCompute runs fragment kernels (imageMain) over an image rather than a
+// fullscreen triangle, see RenderContext::SetComputeExecution.
+enum class ShaderStage { kVertex = 0, kFragment, kGeometry, kCompute, kCount };
 oglbase::ShaderSources_t const &KernelSuffix(ShaderStage _stage);
 oglbase::ShaderSources_t const &DefaultKernel(ShaderStage _stage);
 GLenum ShaderStageToGLenum(ShaderStage _stage);
 
 
+// Live shader of each stage. Shaders and linked programs replaced by newer
+// builds are retired to an LRU keyed by the hash of their assembled sources,
+// building the same content again takes them back rather than compiling.
+// Retired objects are deleted least recently used first past the memory
+// budget, as sized by the driver (program binary length, shader source
+// length).
 class ShaderCache
 {
 public:
+	static constexpr std::size_t kDefaultMemoryBudget = 64u << 20u;
+
 	ShaderCache() = default;
 public:
 	template <ShaderStage ... kStages>
@@ -39,10 +53,44 @@ public:
 
 	oglbase::ShaderPtr& operator[](ShaderStage _stage);
 	oglbase::ShaderPtr const& operator[](ShaderStage _stage) const;
+	// Replaces the shader of _stage, the previous one is retired under the
+	// key it was installed with. A null _key keeps _shader from being retired.
+	void Install(ShaderStage _stage, oglbase::ShaderPtr &&_shader, utility::Hash_t _key);
+
+	void RetireShader(utility::Hash_t _key, oglbase::ShaderPtr &&_shader);
+	void RetireProgram(utility::Hash_t _key, oglbase::ProgramPtr &&_program);
+	// Null when _key isn't retired.
+	oglbase::ShaderPtr TakeShader(utility::Hash_t _key);
+	oglbase::ProgramPtr TakeProgram(utility::Hash_t _key);
+	// 0 deletes retired objects right away.
+	void SetMemoryBudget(std::size_t _bytes);
+	std::size_t memory_usage() const { return retired_size_; }
 public:
 	using ShadersContainer_t =
 		std::array<oglbase::ShaderPtr, static_cast<std::size_t>(ShaderStage::kCount)>;
 	ShadersContainer_t cached_shaders_;
+private:
+	struct Retired
+	{
+		utility::Hash_t key;
+		// Either one is set.
+		oglbase::ShaderPtr shader;
+		oglbase::ProgramPtr program;
+		std::size_t size;
+	};
+	// Most recently retired first.
+	using RetiredList_t = std::list<Retired>;
+	using RetiredIndex_t = std::unordered_map<utility::Hash_t, RetiredList_t::iterator>;
+
+	void Retire(RetiredIndex_t &_index, Retired &&_retired);
+	void Trim();
+
+	std::array<utility::Hash_t, static_cast<std::size_t>(ShaderStage::kCount)> cached_keys_{};
+	RetiredList_t retired_;
+	RetiredIndex_t retired_shaders_;
+	RetiredIndex_t retired_programs_;
+	std::size_t retired_size_ = 0u;
+	std::size_t memory_budget_ = kDefaultMemoryBudget;
 };
 
 
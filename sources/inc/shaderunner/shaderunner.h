@@ -12,37 +12,162 @@
 #define __YS_SHADERUNNER_HPP__
 
 #include <array>
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "shaderunner/shader_cache.h"
+#include "shaderunner/uniform_store.h"
 
 #include "utility/callback.h"
 
 namespace sr {
 
-using UniformContainer = std::vector<std::pair<std::string, float>>;
 using ErrorLogContainer = std::vector<std::pair<int, std::string>>;
 
 using Mat4_t = std::array<float, 16>;
 using Vec3_t = std::array<float, 3>;
+using Vec4_t = std::array<float, 4>;
+
+// Order in which compute workgroups walk the image.
+enum class ComputeTileOrder { kRowMajor = 0, kMorton };
+
+// Summed SR_COST of a tile, x and y are its lower left pixel.
+struct CostTile
+{
+    int x;
+    int y;
+    std::uint32_t cost;
+};
+
+struct CostStats
+{
+    std::uint32_t total;
+    std::uint32_t max;
+    float mean;
+    int tile_size;
+    // Costliest tiles first.
+    std::vector<CostTile> hot_tiles;
+};
 
 class RenderContext
 {
 public:
-    static constexpr unsigned kGizmoCountMax = 16u;
+    static constexpr float kDefaultFrameBudget = 1.f / 60.f;
+    static constexpr int kDefaultTileSize = 64;
+    static constexpr float kDefaultMinResolutionScale = 0.25f;
+    static constexpr int kDefaultAccumulationSamples = 64;
+    static constexpr float kDefaultUniformFreezeDelay = 2.f;
+    static constexpr int kDefaultWorkgroupSize = 8;
+    static constexpr float kDefaultHeatmapOpacity = 0.75f;
+    static constexpr int kDefaultPrepassTileSize = 8;
 public:
 	RenderContext();
 	~RenderContext();
 
 	bool RenderFrame();
+	bool RenderFrame(float _time);
 	void WatchKernelFile(ShaderStage _stage, char const *_path);
+	// Searched by kernel #include directives, after the including file directory.
+	void AddKernelIncludePath(char const *_path);
+	// Blocks until the kernels picked up so far are compiled and linked.
+	void WaitKernelsBuild();
+	void SetKernelReloadDebounce(float _seconds);
+	// Bytes of replaced shaders and programs kept around for builds of the same
+	// sources (ShaderCache::kDefaultMemoryBudget), 0 to delete them right away.
+	void SetShaderMemoryBudget(std::size_t _bytes);
+	// Fragment kernels (*.frag.glsl) of _directory, built in the background
+	// one at a time whenever no kernel of this context is being built. Once a
+	// kernel is ready, switching to it (PlayKernel, or WatchKernelFile with
+	// its path) installs the linked program without compiling. Returns the
+	// kernel count.
+	int SetKernelPlaylist(char const *_directory);
+	int GetPlaylistSize() const;
+	std::string const &GetPlaylistKernel(int _index) const;
+	bool IsPlaylistKernelReady(int _index) const;
+	// Watches the kernel as the fragment kernel, with a crossfade of
+	// _crossfade seconds from the current one once it is installed.
+	void PlayKernel(int _index, float _crossfade = 0.f);
+	// Spreads the kernel pass over several frames, _frame_budget in seconds.
+	void SetProgressiveRendering(bool _enable,
+	                             float _frame_budget = kDefaultFrameBudget,
+	                             int _tile_size = kDefaultTileSize);
+	// Scales the kernel render resolution so that the GPU time of RenderFrame
+	// meets _target_frame_time (seconds), the result is stretched to the
+	// viewport with _filter (GL_NEAREST or GL_LINEAR).
+	void SetResolutionGovernor(bool _enable, float _target_frame_time,
+	                           GLenum _filter = GL_LINEAR,
+	                           float _min_scale = kDefaultMinResolutionScale);
+	float GetResolutionScale() const;
+	// Runs the fragment kernel as a ShaderStage::kCompute kernel, one thread
+	// per pixel in _workgroup_width x _workgroup_height workgroups walking the
+	// image in _tile_order. Kernels relying on rasterization (gl_FragCoord,
+	// derivatives, discard) don't compile this way, the current program is
+	// kept until the kernel builds in the new mode.
+	void SetComputeExecution(bool _enable,
+	                         int _workgroup_width = kDefaultWorkgroupSize,
+	                         int _workgroup_height = kDefaultWorkgroupSize,
+	                         ComputeTileOrder _tile_order = ComputeTileOrder::kRowMajor);
+	// Builds the fragment kernel for profiling: SR_COST(n) adds n to the cost
+	// of the pixel (a no-op otherwise), and braced loop bodies add one per
+	// iteration. Costs are drawn as a heatmap over the kernel output with
+	// _heatmap_opacity, 0 to only gather statistics.
+	void SetCostProfiling(bool _enable, float _heatmap_opacity = kDefaultHeatmapOpacity);
+	// Costs of the previous profiled frame, totals wrap past 2^32.
+	CostStats const &GetCostStats() const;
+	// Builds the image pass with srSetHit(ray_origin, ray_direction, distance)
+	// recording the hit of its pixel, the hits of the previous frame are then
+	// visible as iPrevHits (world position, distance in w, 0 on a miss) along
+	// with iPrevProjMat. srRayStart(ray_origin, ray_direction) returns a safe
+	// distance to start marching from for static scenes seen through iProjMat,
+	// 0 on disocclusion. Both helpers are no-ops otherwise.
+	void SetTemporalRayReuse(bool _enable);
+	// Kernels declaring a "#pragma sr_pass prepass" section get it rendered
+	// once per _tile_size^2 pixel tile ahead of the image pass, with
+	// frag_coord at the tile center. It outputs in red a distance every ray of
+	// the tile can start marching from, which the image pass reads back with
+	// srPrepassStart(frag_coord). Disabled, srPrepassStart returns 0.
+	void SetDepthPrepass(bool _enable, int _tile_size = kDefaultPrepassTileSize);
+	// Averages one jittered (iJitter) sample per frame while the camera, the
+	// uniforms and the kernel stay the same, up to _max_samples.
+	void SetAccumulation(bool _enable, int _max_samples = kDefaultAccumulationSamples);
+	int GetAccumulatedSamples() const;
+	// Bakes uniforms left untouched for _idle_delay seconds into a specialized
+	// kernel built in the background, so that the compiler can fold them.
+	void SetUniformFreezing(bool _enable, float _idle_delay = kDefaultUniformFreezeDelay);
+	int GetFrozenUniformCount() const;
+	// Picks up kernel file changes and finished builds without rendering, for
+	// hosts that only render on demand. RenderFrame polls as well.
+	void Poll();
+	// Whether the live kernel reads iTime, as reported once linked.
+	bool UsesTime() const;
+	// Whether a RenderFrame would differ from the last one: the kernel or one
+	// of its inputs (uniforms, resolution, camera, gizmos) changed, it is
+	// animated, or a progressive pass or sample accumulation is unfinished.
+	bool NeedsRedraw() const;
+	// GPU time of a recent RenderFrame in seconds, lags a few frames behind.
+	float GetGPUFrameTime() const;
 	void SetResolution(int _width, int _height);
 
-    void SetUniforms(UniformContainer const&_uniforms);
-
-    UniformContainer const &GetUniforms() const;
+    void SetUniforms(UniformStore const&_uniforms);
+	// Handle of _name for SetUniformValue, the uniform is added (at 0) when
+	// missing and retyped when it has another type.
+	int ResolveUniform(char const *_name, UniformType _type = UniformType::kFloat);
+	// Only applies to kFloat uniforms.
+	void SetUniformValue(int _handle, float _value);
+	// _data holds the UniformComponentCount components of the uniform type.
+	void SetUniformData(int _handle, void const *_data);
+	// Renders _count frames at _times into an offscreen target at the current
+	// resolution, _prepare is invoked ahead of each frame to update the
+	// context. Frames are copied to o_pixels (may be null) as tightly packed
+	// RGBA8 images, rows bottom-up. Returns the number of frames rendered, or
+	// copied when o_pixels is set, 0 when _times is null.
+	int RenderFrames(float const *_times, int _count, void *o_pixels,
+	                 std::function<void(int)> const &_prepare = {});
+
+    UniformStore const &GetUniforms() const;
 	std::string const &GetKernelPath(ShaderStage _stage) const;
 
     utility::Callback<std::string const&, ErrorLogContainer const&> onFKernelCompileFinished;
@@ -51,8 +176,10 @@ public:
                               0.f, 1.f, 0.f, 0.f,
                               0.f, 0.f, 1.f, 0.f,
                               0.f, 0.f, 0.f, 1.f };
-    int gizmo_count = 0;
-    Vec3_t gizmo_positions[kGizmoCountMax];
+    // Kernels see them as iGizmos[iGizmoCount] and iGizmoParams[iGizmoCount],
+    // params missing for a gizmo read as zeros.
+    std::vector<Vec3_t> gizmo_positions;
+    std::vector<Vec4_t> gizmo_params;
 
 private:
 	struct Impl_;
@@ -69,20 +196,44 @@ extern "C"
     {
         float res[2];
 
+        // Uniform values, matched by name when unames is set, otherwise by
+        // handle from srResolveUniform (uhandles, or 0..ucount-1 when null).
+        // uvalues packs the 4 byte components of each uniform one after the
+        // other, typed by utypes (sr::UniformType), floats when it is null.
+        // A value is skipped when its handle refers to another type, an
+        // unknown type ends the list as the values after it can't be located.
         char const** unames;
-        float* uvalues;
+        int const* uhandles;
+        std::uint32_t const* utypes;
+        void const* uvalues;
         int ucount;
 
         float projection_matrix[16];
         int gizmo_count;
-        float gizmo_positions[3*16];
+        float const* gizmo_positions;   // 3 floats per gizmo
+        float const* gizmo_params;      // 4 floats per gizmo, may be null
     };
 
     void* srCreateContext();
     void srDeleteContext(void* context);
     bool srRenderFrame(void* context, FrameDesc const* desc);
+    // Renders count frames with descs[i] at times[i] into an offscreen target
+    // sized by descs[0].res, pixels receives count RGBA8 frames (may be null).
+    // Like srRenderFrame, null descs render with the current context state,
+    // null times render nothing and return 0.
+    int srRenderFrames(void* context, FrameDesc const* descs, float const* times, int count, void* pixels);
+    int srResolveUniform(void* context, char const* name);
+    int srResolveTypedUniform(void* context, char const* name, std::uint32_t type);
+    void srSetUniformValue(void* context, int handle, float value);
+    void srSetUniformData(void* context, int handle, void const* data);
+    // Fills up to capacity names/types/values (any may be null), returns the
+    // uniform count. Names and values stay valid until the uniforms change.
+    int srGetUniforms(void* context, char const** names, std::uint32_t* types, void const** values, int capacity);
+    void srSetResolution(void* context, int width, int height);
+    void srWaitKernelsBuild(void* context);
     void srWatchKernelFile(void* context, std::uint32_t stage, char const* path);
     char const* srGetKernelPath(void* context, std::uint32_t stage);
+    float srGetGPUFrameTime(void* context);
 
 }
 
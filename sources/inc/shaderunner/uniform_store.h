@@ -0,0 +1,92 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_UNIFORM_STORE_HPP__
+#define __YS_UNIFORM_STORE_HPP__
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace sr {
+
+
+// GLSL types of kernel uniforms. Every component takes 4 bytes: a float, or
+// an int for the integer types and bool. Matrices are column-major.
+enum class UniformType : std::uint32_t
+{
+	kFloat = 0, kVec2, kVec3, kVec4,
+	kInt, kIVec2, kIVec3, kIVec4,
+	kBool,
+	kMat3, kMat4,
+	kCount
+};
+std::size_t UniformComponentCount(UniformType _type);
+bool IsIntegerUniform(UniformType _type);
+// GLSL keyword of _type.
+char const *UniformTypeName(UniformType _type);
+// Type glGetActiveUniform reports for a declaration of _type.
+GLenum UniformTypeToGLenum(UniformType _type);
+
+
+// Uniform values packed one after the other in a single blob of components,
+// looked up by name through an index. Handles are positions in the store and
+// never change, value offsets move when a uniform ahead is retyped.
+// Names are expected to be unique, Find returns the first uniform of a name.
+class UniformStore
+{
+public:
+	struct Uniform
+	{
+		std::string name;
+		UniformType type;
+		// In components from the start of the blob.
+		std::size_t offset;
+	};
+public:
+	UniformStore() = default;
+public:
+	// Handle of _name, appended with zeroed components when missing. A
+	// uniform of _name with another type is retyped (and zeroed) in place.
+	int Add(std::string const &_name, UniformType _type = UniformType::kFloat);
+	int Find(std::string const &_name) const;
+	void Rename(std::size_t _index, std::string const &_name);
+
+	// Copies UniformComponentCount components from _data, returns whether
+	// the value changed.
+	bool Set(std::size_t _index, void const *_data);
+	void* data(std::size_t _index);
+	void const* data(std::size_t _index) const;
+
+	// Same names and types in the same order, values aside.
+	bool SameLayout(UniformStore const &_other) const;
+
+	std::size_t size() const { return uniforms_.size(); }
+	bool empty() const { return uniforms_.empty(); }
+	Uniform const &operator[](std::size_t _index) const { return uniforms_[_index]; }
+
+	std::uint32_t const* blob() const { return blob_.data(); }
+	std::size_t blob_size() const { return blob_.size(); }
+private:
+	void Retype(std::size_t _index, UniformType _type);
+
+	std::vector<Uniform> uniforms_;
+	std::vector<std::uint32_t> blob_;
+	std::unordered_map<std::string, std::size_t> index_;
+};
+
+
+} // namespace sr
+
+
+#endif // __YS_UNIFORM_STORE_HPP__
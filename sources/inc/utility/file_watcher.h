@@ -0,0 +1,51 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_FILE_WATCHER_HPP__
+#define __YS_FILE_WATCHER_HPP__
+
+#include <string>
+
+#include "utility/callback.h"
+
+namespace utility {
+
+// Reports modifications of a set of files. On Linux the parent directories are
+// watched through inotify, which also catches editors saving through a rename.
+// Elsewhere modification times are polled. A change is only reported once no
+// other event touched the file for the debounce window, so that files being
+// truncated then written are read once complete.
+class FileWatcher
+{
+public:
+	static constexpr float kDefaultDebounce = 0.1f;
+public:
+	explicit FileWatcher(float _debounce = kDefaultDebounce);
+	~FileWatcher();
+	FileWatcher(FileWatcher const&) = delete;
+	FileWatcher& operator=(FileWatcher const&) = delete;
+
+	// Paths are expected in the form produced by utility::File.
+	void Watch(std::string const &_path);
+	void Unwatch(std::string const &_path);
+	void SetDebounce(float _debounce);
+
+	// Non blocking, onFileChanged is invoked from there.
+	void Poll();
+
+	Callback<std::string const&> onFileChanged;
+private:
+	struct Impl_;
+	Impl_* impl_;
+};
+
+} // namespace utility
+
+#endif // __YS_FILE_WATCHER_HPP__
@@ -0,0 +1,47 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#pragma once
+#ifndef __YS_HASH_HPP__
+#define __YS_HASH_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace utility {
+
+// FNV-1a, 64 bits. Hashes are chained by feeding the previous result as seed.
+using Hash_t = std::uint64_t;
+static constexpr Hash_t kHashSeed = 0xcbf29ce484222325ull;
+
+inline Hash_t HashBytes(void const *_data, std::size_t _size, Hash_t _seed = kHashSeed)
+{
+    static constexpr Hash_t kPrime = 0x100000001b3ull;
+    unsigned char const *bytes = static_cast<unsigned char const*>(_data);
+    Hash_t result = _seed;
+    for (std::size_t i = 0; i < _size; ++i)
+        result = (result ^ static_cast<Hash_t>(bytes[i])) * kPrime;
+    return result;
+}
+
+inline Hash_t HashString(char const *_str, Hash_t _seed = kHashSeed)
+{ return HashBytes(_str, std::strlen(_str), _seed); }
+
+inline Hash_t HashString(std::string const &_str, Hash_t _seed = kHashSeed)
+{ return HashBytes(_str.data(), _str.size(), _seed); }
+
+template <typename T>
+inline Hash_t HashValue(T const &_value, Hash_t _seed = kHashSeed)
+{ return HashBytes(&_value, sizeof(T), _seed); }
+
+} // namespace utility
+
+#endif // __YS_HASH_HPP__
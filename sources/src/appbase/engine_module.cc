@@ -0,0 +1,308 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. You can do whatever you want with this
+ * stuff. If we meet some day, and you think this stuff is worth it, you can
+ * buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "appbase/engine_module.h"
+
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include "utility/file.h"
+
+namespace {
+
+namespace boostfs = ::boost::filesystem;
+
+#ifdef _WIN32
+void* OpenLibrary(std::string const &_path) { return LoadLibraryA(_path.c_str()); }
+void* LibrarySymbol(void* _library, char const *_name)
+{ return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(_library), _name)); }
+void CloseLibrary(void* _library) { FreeLibrary(static_cast<HMODULE>(_library)); }
+std::string LibraryError() { return "error " + std::to_string(GetLastError()); }
+#else
+void* OpenLibrary(std::string const &_path) { return dlopen(_path.c_str(), RTLD_NOW | RTLD_LOCAL); }
+void* LibrarySymbol(void* _library, char const *_name) { return dlsym(_library, _name); }
+void CloseLibrary(void* _library) { dlclose(_library); }
+std::string LibraryError() { char const* error = dlerror(); return error ? error : ""; }
+#endif
+
+} // namespace
+
+namespace appbase {
+
+struct EngineModule::Module
+{
+    ~Module()
+    {
+        if (library)
+            CloseLibrary(library);
+        boost::system::error_code error{};
+        boostfs::remove(copy_path, error);
+    }
+
+    void* library = nullptr;
+    // The module is loaded from a copy, so that the build can replace the
+    // original while it is in use and so that the loader doesn't hand back
+    // the already loaded library for the same path.
+    std::string copy_path;
+
+    decltype(&srCreateContext) create_context = nullptr;
+    decltype(&srDeleteContext) delete_context = nullptr;
+    decltype(&srRenderFrame) render_frame = nullptr;
+    decltype(&srRenderFrames) render_frames = nullptr;
+    decltype(&srWatchKernelFile) watch_kernel_file = nullptr;
+    decltype(&srGetKernelPath) get_kernel_path = nullptr;
+    decltype(&srGetGPUFrameTime) get_gpu_frame_time = nullptr;
+    decltype(&srResolveUniform) resolve_uniform = nullptr;
+    decltype(&srResolveTypedUniform) resolve_typed_uniform = nullptr;
+    decltype(&srSetUniformValue) set_uniform_value = nullptr;
+    decltype(&srSetUniformData) set_uniform_data = nullptr;
+    decltype(&srGetUniforms) get_uniforms = nullptr;
+    decltype(&srSetResolution) set_resolution = nullptr;
+    decltype(&srWaitKernelsBuild) wait_kernels_build = nullptr;
+};
+
+
+EngineModule::EngineModule(std::string const &_module_path, float _reload_debounce) :
+    module_path_{ utility::File{ _module_path }.path() },
+    module_watcher_{ _reload_debounce },
+    module_changed_{ false },
+    module_{},
+    context_{ nullptr },
+    resolution_{ 0, 0 }
+{
+    module_watcher_.onFileChanged.listeners_.emplace_back(
+        [this](std::string const&) {
+            this->module_changed_ = true;
+        });
+    module_watcher_.Watch(module_path_);
+
+    std::unique_ptr<Module> module = Load(module_path_);
+    if (module)
+        Swap(std::move(module));
+}
+
+EngineModule::~EngineModule()
+{
+    if (module_ && context_)
+        module_->delete_context(context_);
+}
+
+bool
+EngineModule::loaded() const
+{
+    return module_ && context_;
+}
+
+void
+EngineModule::Poll()
+{
+    module_watcher_.Poll();
+    if (!module_changed_)
+        return;
+    module_changed_ = false;
+
+    std::unique_ptr<Module> module = Load(module_path_);
+    if (!module)
+    {
+        std::cout << "Engine module reload failed, keeping the current engine" << std::endl;
+        return;
+    }
+    Swap(std::move(module));
+}
+
+std::unique_ptr<EngineModule::Module>
+EngineModule::Load(std::string const &_module_path)
+{
+    boostfs::path const module_path{ _module_path };
+    if (!boostfs::is_regular_file(module_path))
+    {
+        std::cout << "Engine module " << _module_path << " not found" << std::endl;
+        return nullptr;
+    }
+
+    std::unique_ptr<Module> module = std::make_unique<Module>();
+    boostfs::path const copy_path = boostfs::temp_directory_path() /
+        boostfs::unique_path("sr-%%%%-%%%%" + module_path.extension().string());
+    boost::system::error_code error{};
+    boostfs::copy_file(module_path, copy_path, error);
+    if (error)
+    {
+        std::cout << "Engine module copy failed: " << error.message() << std::endl;
+        return nullptr;
+    }
+    module->copy_path = copy_path.string();
+
+    module->library = OpenLibrary(module->copy_path);
+    if (!module->library)
+    {
+        std::cout << "Engine module load failed: " << LibraryError() << std::endl;
+        return nullptr;
+    }
+
+    bool resolved = true;
+    auto const resolve = [&module, &resolved](auto &o_function, char const *_name) {
+        o_function = reinterpret_cast<std::remove_reference_t<decltype(o_function)>>(
+            LibrarySymbol(module->library, _name));
+        if (!o_function)
+        {
+            std::cout << "Engine module is missing " << _name << std::endl;
+            resolved = false;
+        }
+    };
+    resolve(module->create_context, "srCreateContext");
+    resolve(module->delete_context, "srDeleteContext");
+    resolve(module->render_frame, "srRenderFrame");
+    resolve(module->render_frames, "srRenderFrames");
+    resolve(module->watch_kernel_file, "srWatchKernelFile");
+    resolve(module->get_kernel_path, "srGetKernelPath");
+    resolve(module->get_gpu_frame_time, "srGetGPUFrameTime");
+    resolve(module->resolve_uniform, "srResolveUniform");
+    resolve(module->resolve_typed_uniform, "srResolveTypedUniform");
+    resolve(module->set_uniform_value, "srSetUniformValue");
+    resolve(module->set_uniform_data, "srSetUniformData");
+    resolve(module->get_uniforms, "srGetUniforms");
+    resolve(module->set_resolution, "srSetResolution");
+    resolve(module->wait_kernels_build, "srWaitKernelsBuild");
+    if (!resolved)
+        return nullptr;
+
+    return module;
+}
+
+void
+EngineModule::Swap(std::unique_ptr<Module> &&_module)
+{
+    void* const context = _module->create_context();
+
+    if (module_ && context_)
+    {
+        for (std::uint32_t stage = 0u; stage < static_cast<std::uint32_t>(sr::ShaderStage::kCount); ++stage)
+        {
+            std::string const kernel_path = module_->get_kernel_path(context_, stage);
+            if (!kernel_path.empty())
+                _module->watch_kernel_file(context, stage, kernel_path.c_str());
+        }
+
+        // Resolved in the same order, so that handles remain valid.
+        int const uniform_count = module_->get_uniforms(context_, nullptr, nullptr, nullptr, 0);
+        std::vector<char const*> uniform_names(static_cast<std::size_t>(uniform_count), nullptr);
+        std::vector<std::uint32_t> uniform_types(static_cast<std::size_t>(uniform_count), 0u);
+        std::vector<void const*> uniform_values(static_cast<std::size_t>(uniform_count), nullptr);
+        module_->get_uniforms(context_, uniform_names.data(), uniform_types.data(), uniform_values.data(),
+                              uniform_count);
+        for (std::size_t i = 0; i < uniform_names.size(); ++i)
+        {
+            int const handle = _module->resolve_typed_uniform(context, uniform_names[i], uniform_types[i]);
+            _module->set_uniform_data(context, handle, uniform_values[i]);
+        }
+
+        module_->delete_context(context_);
+    }
+
+    if (resolution_[0] > 0 && resolution_[1] > 0)
+        _module->set_resolution(context, resolution_[0], resolution_[1]);
+    _module->wait_kernels_build(context);
+
+    bool const reloaded = static_cast<bool>(module_);
+    module_ = std::move(_module);
+    context_ = context;
+    if (reloaded)
+    {
+        std::cout << "Engine module reloaded" << std::endl;
+        onModuleReloaded();
+    }
+}
+
+bool
+EngineModule::RenderFrame(FrameDesc const *_desc)
+{
+    if (!loaded())
+        return false;
+    if (_desc && _desc->res[0] >= 1.f && _desc->res[1] >= 1.f)
+    {
+        resolution_[0] = static_cast<int>(_desc->res[0]);
+        resolution_[1] = static_cast<int>(_desc->res[1]);
+    }
+    return module_->render_frame(context_, _desc);
+}
+
+int
+EngineModule::RenderFrames(FrameDesc const *_descs, float const *_times, int _count, void *o_pixels)
+{
+    if (!loaded())
+        return 0;
+    if (_count > 0 && _descs[0].res[0] >= 1.f && _descs[0].res[1] >= 1.f)
+    {
+        resolution_[0] = static_cast<int>(_descs[0].res[0]);
+        resolution_[1] = static_cast<int>(_descs[0].res[1]);
+    }
+    return module_->render_frames(context_, _descs, _times, _count, o_pixels);
+}
+
+void
+EngineModule::WatchKernelFile(sr::ShaderStage _stage, char const *_path)
+{
+    if (loaded())
+        module_->watch_kernel_file(context_, static_cast<std::uint32_t>(_stage), _path);
+}
+
+void
+EngineModule::WaitKernelsBuild()
+{
+    if (loaded())
+        module_->wait_kernels_build(context_);
+}
+
+std::string
+EngineModule::GetKernelPath(sr::ShaderStage _stage) const
+{
+    return loaded()
+        ? std::string{ module_->get_kernel_path(context_, static_cast<std::uint32_t>(_stage)) }
+        : std::string{};
+}
+
+int
+EngineModule::ResolveUniform(char const *_name)
+{
+    return loaded() ? module_->resolve_uniform(context_, _name) : -1;
+}
+
+void
+EngineModule::SetUniformValue(int _handle, float _value)
+{
+    if (loaded())
+        module_->set_uniform_value(context_, _handle, _value);
+}
+
+void
+EngineModule::SetResolution(int _width, int _height)
+{
+    resolution_[0] = _width;
+    resolution_[1] = _height;
+    if (loaded())
+        module_->set_resolution(context_, _width, _height);
+}
+
+float
+EngineModule::GetGPUFrameTime() const
+{
+    return loaded() ? module_->get_gpu_frame_time(context_) : 0.f;
+}
+
+} // namespace appbase
@@ -110,46 +110,186 @@ ImGuiLayer::RunFrame(State& _state)
 
             ImGui::Checkbox("Enable gizmos", &_state.enable_gizmos);
 
+            ImGui::Checkbox("Progressive rendering", &_state.progressive_rendering);
+            if (_state.progressive_rendering)
+            {
+                ImGui::SameLine();
+                ImGui::PushItemWidth(-1);
+                ImGui::DragFloat("DF_progressive_budget", &_state.progressive_budget_ms,
+                                 0.1f, 1.f, 1000.f, "%.1f ms");
+                ImGui::PopItemWidth();
+            }
+
+            ImGui::Checkbox("Dynamic resolution", &_state.dynamic_resolution);
+            if (_state.dynamic_resolution)
+            {
+                ImGui::SameLine();
+                ImGui::PushItemWidth(-1);
+                ImGui::DragFloat("DF_dynamic_resolution_target", &_state.dynamic_resolution_target_ms,
+                                 0.1f, 1.f, 1000.f, "%.1f ms");
+                ImGui::PopItemWidth();
+
+                ImGui::Checkbox("Linear upscale", &_state.dynamic_resolution_linear);
+                if (ResolutionScale_query.source_)
+                {
+                    ImGui::SameLine();
+                    ImGui::Text("scale %.2f", ResolutionScale_query());
+                }
+            }
+
+            ImGui::Checkbox("Accumulate samples", &_state.accumulate_samples);
+            if (_state.accumulate_samples && AccumulatedSamples_query.source_)
+            {
+                ImGui::SameLine();
+                ImGui::Text("%d spp", AccumulatedSamples_query());
+            }
+
+            ImGui::Checkbox("Compute execution", &_state.compute_execution);
+            if (_state.compute_execution)
+            {
+                ImGui::SameLine();
+                ImGui::Checkbox("Morton order", &_state.compute_morton_order);
+            }
+
+            ImGui::Checkbox("Reuse ray starts", &_state.temporal_ray_reuse);
+            ImGui::Checkbox("Depth prepass", &_state.depth_prepass);
+
+            ImGui::Checkbox("Render on demand", &_state.render_on_demand);
+
+            if (FrameTimings_query.source_ && ImGui::CollapsingHeader("GPU timings"))
+            {
+                FrameTimings const timings = FrameTimings_query();
+                ImGui::Text("shaderunner %.3f ms", timings.shaderunner * 1000.f);
+                ImGui::Text("gizmo       %.3f ms", timings.gizmo * 1000.f);
+                ImGui::Text("blit        %.3f ms", timings.blit * 1000.f);
+                ImGui::Text("imgui       %.3f ms", timings.imgui * 1000.f);
+            }
+
+            if (CostStats_query.source_ && ImGui::CollapsingHeader("Kernel cost"))
+            {
+                ImGui::Checkbox("Cost heatmap", &_state.cost_heatmap);
+                if (_state.cost_heatmap)
+                {
+                    ImGui::SameLine();
+                    ImGui::PushItemWidth(-1);
+                    ImGui::DragFloat("DF_cost_heatmap_opacity", &_state.cost_heatmap_opacity,
+                                     0.01f, 0.f, 1.f, "opacity %.2f");
+                    ImGui::PopItemWidth();
+
+                    sr::CostStats const stats = CostStats_query();
+                    ImGui::Text("total %u, mean %.1f, max %u", stats.total, stats.mean, stats.max);
+                    for (sr::CostTile const &tile : stats.hot_tiles)
+                        ImGui::Text("tile %4d %4d  %u", tile.x, tile.y, tile.cost);
+                }
+            }
+
             if (ImGui::CollapsingHeader("Uniforms"))
             {
-                sr::UniformContainer uniforms = Uniforms_query();
+                ImGui::Checkbox("Freeze idle uniforms", &_state.freeze_uniforms);
+                if (_state.freeze_uniforms && FrozenUniforms_query.source_)
+                {
+                    ImGui::SameLine();
+                    ImGui::Text("%d frozen", FrozenUniforms_query());
+                }
+
+                sr::UniformStore uniforms = Uniforms_query();
                 if (ImGui::Button("+"))
                 {
-                    uniforms.emplace_back(std::pair<std::string, float>{"", 0.f});
+                    uniforms.Add("", static_cast<sr::UniformType>(new_uniform_type));
                 } ImGui::SameLine();
 
-                ImGui::Button("-");
+                ImGui::Button("-"); ImGui::SameLine();
+
+                { ImGui::PushItemWidth(-1);
+                    static std::array<char const*, static_cast<std::size_t>(sr::UniformType::kCount)> const
+                        kTypeNames = [](){
+                            std::array<char const*, static_cast<std::size_t>(sr::UniformType::kCount)> result{};
+                            for (std::size_t i = 0; i < result.size(); ++i)
+                                result[i] = sr::UniformTypeName(static_cast<sr::UniformType>(i));
+                            return result;
+                        }();
+                    ImGui::Combo("CB_uniform_type", &new_uniform_type,
+                                 kTypeNames.data(), static_cast<int>(kTypeNames.size()));
+                } ImGui::PopItemWidth();
 
                 { ImGui::PushItemWidth(-100);
                     std::array<char, kUniformMaxLength> buff;
 
                     for (std::size_t i = 0; i < uniforms.size(); ++i)
                     {
-                        std::pair<std::string, float> &uniform = uniforms[i];
+                        std::string const &name = uniforms[i].name;
 
-                        std::size_t bufflength = (kUniformMaxLength < uniform.first.size())
-                            ? kUniformMaxLength
-                            : uniform.first.size();
+                        // Room left for the terminating null.
+                        std::size_t bufflength = (kUniformMaxLength - 1u < name.size())
+                            ? kUniformMaxLength - 1u
+                            : name.size();
 
-                        std::copy(uniform.first.c_str(),
-                                  uniform.first.c_str() + bufflength,
+                        std::copy(name.c_str(),
+                                  name.c_str() + bufflength,
                                   std::begin(buff));
 
                         std::fill(std::begin(buff) + bufflength,
                                   std::end(buff),
                                   '\0');
 
-                        ImGui::DragFloat(
-                            (std::string("DF_uniform") + std::to_string(i)).c_str(),
-                            &uniform.second);
+                        std::string const suffix = std::to_string(i);
+                        float* const floats = static_cast<float*>(uniforms.data(i));
+                        int* const ints = static_cast<int*>(uniforms.data(i));
+                        switch (uniforms[i].type)
+                        {
+                        case sr::UniformType::kFloat:
+                            ImGui::DragFloat(("DF_uniform" + suffix).c_str(), floats);
+                            break;
+                        case sr::UniformType::kVec2:
+                            ImGui::DragFloat2(("DF_uniform" + suffix).c_str(), floats);
+                            break;
+                        case sr::UniformType::kVec3:
+                            ImGui::DragFloat3(("DF_uniform" + suffix).c_str(), floats);
+                            break;
+                        case sr::UniformType::kVec4:
+                            ImGui::DragFloat4(("DF_uniform" + suffix).c_str(), floats);
+                            break;
+                        case sr::UniformType::kInt:
+                            ImGui::DragInt(("DI_uniform" + suffix).c_str(), ints);
+                            break;
+                        case sr::UniformType::kIVec2:
+                            ImGui::DragInt2(("DI_uniform" + suffix).c_str(), ints);
+                            break;
+                        case sr::UniformType::kIVec3:
+                            ImGui::DragInt3(("DI_uniform" + suffix).c_str(), ints);
+                            break;
+                        case sr::UniformType::kIVec4:
+                            ImGui::DragInt4(("DI_uniform" + suffix).c_str(), ints);
+                            break;
+                        case sr::UniformType::kBool:
+                        {
+                            bool value = (ints[0] != 0);
+                            if (ImGui::Checkbox(("CB_uniform" + suffix).c_str(), &value))
+                                ints[0] = value ? 1 : 0;
+                            break;
+                        }
+                        case sr::UniformType::kMat3:
+                            // One column per line.
+                            for (int column = 0; column < 3; ++column)
+                                ImGui::DragFloat3(("DF_uniform" + suffix + "_" + std::to_string(column)).c_str(),
+                                                  floats + column * 3);
+                            break;
+                        case sr::UniformType::kMat4:
+                            for (int column = 0; column < 4; ++column)
+                                ImGui::DragFloat4(("DF_uniform" + suffix + "_" + std::to_string(column)).c_str(),
+                                                  floats + column * 4);
+                            break;
+                        default:
+                            break;
+                        }
 
                         if (ImGui::InputText(
-                                (std::string("IT_uniform") + std::to_string(i)).c_str(),
+                                ("IT_uniform" + suffix).c_str(),
                                 buff.data(),
                                 kUniformMaxLength,
                                 ImGuiInputTextFlags_EnterReturnsTrue))
                         {
-                            uniform.first = std::string(buff.data(), kUniformMaxLength);
+                            uniforms.Rename(i, std::string(buff.data()));
                         }
                     }
                 } ImGui::PopItemWidth();
@@ -157,6 +297,26 @@ ImGuiLayer::RunFrame(State& _state)
                 Uniforms_onReturn(uniforms);
             }
 
+            if (Playlist_query.source_ && ImGui::CollapsingHeader("Playlist"))
+            {
+                ImGui::PushItemWidth(-1);
+                ImGui::DragFloat("DF_playlist_crossfade", &_state.playlist_crossfade_s,
+                                 0.05f, 0.f, 10.f, "crossfade %.2f s");
+                ImGui::PopItemWidth();
+
+                std::vector<std::pair<std::string, bool>> const playlist = Playlist_query();
+                std::string const current_path = FKernelPath_query.source_ ? FKernelPath_query() : std::string{};
+                for (std::size_t i = 0; i < playlist.size(); ++i)
+                {
+                    std::string const &path = playlist[i].first;
+                    std::string label = path.substr(path.find_last_of("/\\") + 1u);
+                    if (!playlist[i].second)
+                        label += " (building)";
+                    if (ImGui::Selectable(label.c_str(), path == current_path))
+                        Playlist_onSelect(static_cast<int>(i));
+                }
+            }
+
             if (ImGui::CollapsingHeader("Compile Errors"))
                 ImGui::TextWrapped(error_console_buffer.c_str(), 0);
 
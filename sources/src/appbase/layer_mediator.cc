@@ -9,6 +9,7 @@
 
 #include "appbase/layer_mediator.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include <imgui.h>
@@ -82,6 +83,14 @@ LayerMediator::LayerMediator(uibase::Vec2i_t const& _screen_size, unsigned _flag
         imgui_layer_->imgui_context_.SetResolution(state_.screen_size[0], state_.screen_size[1]);
     }
 
+    if (imgui_layer_)
+    {
+        imgui_layer_->FrameTimings_query.source_ =
+            [this] () {
+                return this->timings_;
+            };
+    }
+
     if (sr_layer_ && imgui_layer_)
     {
         sr_layer_->onFKernelCompileFinished.listeners_.emplace_back(
@@ -105,25 +114,60 @@ LayerMediator::LayerMediator(uibase::Vec2i_t const& _screen_size, unsigned _flag
             };
 
         imgui_layer_->Uniforms_onReturn.listeners_.emplace_back(
-            [this] (sr::UniformContainer const&_uniforms) {
+            [this] (sr::UniformStore const&_uniforms) {
                 this->sr_layer_->SetUniforms(_uniforms);
             });
+
+        imgui_layer_->ResolutionScale_query.source_ =
+            [this] () {
+                return this->sr_layer_->GetResolutionScale();
+            };
+
+        imgui_layer_->AccumulatedSamples_query.source_ =
+            [this] () {
+                return this->sr_layer_->GetAccumulatedSamples();
+            };
+
+        imgui_layer_->FrozenUniforms_query.source_ =
+            [this] () {
+                return this->sr_layer_->GetFrozenUniformCount();
+            };
+
+        imgui_layer_->CostStats_query.source_ =
+            [this] () {
+                return this->sr_layer_->GetCostStats();
+            };
+
+        imgui_layer_->Playlist_query.source_ =
+            [this] () {
+                std::vector<std::pair<std::string, bool>> result{};
+                for (int i = 0; i < this->sr_layer_->GetPlaylistSize(); ++i)
+                    result.emplace_back(this->sr_layer_->GetPlaylistKernel(i),
+                                        this->sr_layer_->IsPlaylistKernelReady(i));
+                return result;
+            };
+
+        imgui_layer_->Playlist_onSelect.listeners_.emplace_back(
+            [this] (int _index) {
+                this->sr_layer_->PlayKernel(_index, this->state_.playlist_crossfade_s);
+            });
     }
 
     if (sr_layer_ && gizmo_layer_)
     {
-        for (std::uint32_t i = 0;
-             i < sr_layer_->kGizmoCountMax && i < gizmo_layer_->gizmos_.size();
-             ++i)
+        sr_layer_->gizmo_positions.resize(gizmo_layer_->gizmos_.size());
+        sr_layer_->gizmo_params.resize(gizmo_layer_->gizmos_.size());
+        for (std::uint32_t i = 0; i < gizmo_layer_->gizmos_.size(); ++i)
         {
             std::cout << gizmo_layer_->gizmos_[i].position_[0] << " " << gizmo_layer_->gizmos_[i].position_[1] << " " << gizmo_layer_->gizmos_[i].position_[2] << std::endl;
 
             std::memcpy(&(sr_layer_->gizmo_positions[i]),
                         &gizmo_layer_->gizmos_[i].position_[0],
                         sizeof(float)*3);
+            sr_layer_->gizmo_params[i] = sr::Vec4_t{
+                static_cast<float>(gizmo_layer_->gizmos_[i].type_), 0.f, 0.f, 0.f
+            };
         }
-
-        sr_layer_->gizmo_count = (int)gizmo_layer_->gizmos_.size();
     }
 
     back_state_ = state_;
@@ -258,7 +302,7 @@ LayerMediator::MouseDelta(uibase::Vec2i_t const& _delta)
                 std::memcpy(&gizmo.position_[0], &result[0], 3*sizeof(float));
 
                 std::uint32_t const gizmo_index = uibase::UnpackGizmoIndex(state_.select_gizmo);
-                if (gizmo_index < sr_layer_->kGizmoCountMax)
+                if (gizmo_index >= 1u && gizmo_index <= sr_layer_->gizmo_positions.size())
                     std::memcpy(&(sr_layer_->gizmo_positions[gizmo_index-1]),
                                 &gizmo.position_[0],
                                 sizeof(float)*3);
@@ -431,11 +475,57 @@ LayerMediator::RunFrame(float _dt)
 
     if (sr_layer_)
     {
+        if (state_.progressive_rendering != back_state_.progressive_rendering ||
+            state_.progressive_budget_ms != back_state_.progressive_budget_ms)
+        {
+            sr_layer_->SetProgressiveRendering(state_.progressive_rendering,
+                                               state_.progressive_budget_ms / 1000.f);
+        }
+
+        if (state_.dynamic_resolution != back_state_.dynamic_resolution ||
+            state_.dynamic_resolution_target_ms != back_state_.dynamic_resolution_target_ms ||
+            state_.dynamic_resolution_linear != back_state_.dynamic_resolution_linear)
+        {
+            sr_layer_->SetResolutionGovernor(state_.dynamic_resolution,
+                                             state_.dynamic_resolution_target_ms / 1000.f,
+                                             state_.dynamic_resolution_linear ? GL_LINEAR : GL_NEAREST);
+        }
+
+        if (state_.accumulate_samples != back_state_.accumulate_samples)
+            sr_layer_->SetAccumulation(state_.accumulate_samples);
+
+        if (state_.freeze_uniforms != back_state_.freeze_uniforms)
+            sr_layer_->SetUniformFreezing(state_.freeze_uniforms);
+
+        if (state_.compute_execution != back_state_.compute_execution ||
+            state_.compute_morton_order != back_state_.compute_morton_order)
+        {
+            sr_layer_->SetComputeExecution(state_.compute_execution,
+                                           sr::RenderContext::kDefaultWorkgroupSize,
+                                           sr::RenderContext::kDefaultWorkgroupSize,
+                                           state_.compute_morton_order ? sr::ComputeTileOrder::kMorton
+                                                                       : sr::ComputeTileOrder::kRowMajor);
+        }
+
+        if (state_.temporal_ray_reuse != back_state_.temporal_ray_reuse)
+            sr_layer_->SetTemporalRayReuse(state_.temporal_ray_reuse);
+
+        if (state_.depth_prepass != back_state_.depth_prepass)
+            sr_layer_->SetDepthPrepass(state_.depth_prepass);
+
+        if (state_.cost_heatmap != back_state_.cost_heatmap ||
+            state_.cost_heatmap_opacity != back_state_.cost_heatmap_opacity)
+        {
+            sr_layer_->SetCostProfiling(state_.cost_heatmap, state_.cost_heatmap_opacity);
+        }
+
         sr_layer_->projection_matrix = uibase::mat4_mul(
             MakeGizmoLayerProjection(state_.screen_size),
             cammat
         );
+        shaderunner_timer_.Begin();
         result = sr_layer_->RenderFrame();
+        shaderunner_timer_.End();
     }
 
     if (gizmo_layer_)
@@ -445,13 +535,17 @@ LayerMediator::RunFrame(float _dt)
             cammat
         );
 
+        gizmo_timer_.Begin();
         if (state_.enable_gizmos)
             gizmo_layer_->RenderFrame();
         else
             gizmo_layer_->ClearIDBuffer();
+        gizmo_timer_.End();
 
         framebuffer_->Unbind();
 
+        blit_timer_.Begin();
+
         glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_->fbo_);
         glReadBuffer(GL_COLOR_ATTACHMENT0);
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
@@ -459,15 +553,45 @@ LayerMediator::RunFrame(float _dt)
         glBlitFramebuffer(0, 0, state_.screen_size[0], state_.screen_size[1],
                           0, 0, state_.screen_size[0], state_.screen_size[1],
                           GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        blit_timer_.End();
     }
 
     if (imgui_layer_)
+    {
+        imgui_timer_.Begin();
         imgui_layer_->RunFrame(state_);
+        imgui_timer_.End();
+    }
+
+    timings_.shaderunner = shaderunner_timer_.elapsed();
+    timings_.gizmo = gizmo_timer_.elapsed();
+    timings_.blit = blit_timer_.elapsed();
+    timings_.imgui = imgui_timer_.elapsed();
 
     back_state_ = state_;
     return result;
 }
 
+bool
+LayerMediator::NeedsFrame() const
+{
+    if (!state_.render_on_demand)
+        return true;
+
+    static constexpr std::uint32_t kCameraKeys[] = {
+        appbase::kUp, appbase::kDown, appbase::kLeft, appbase::kRight,
+        'w', 's', 'd', 'a', 'q', 'e'
+    };
+    bool const camera_moving = std::any_of(std::begin(kCameraKeys), std::end(kCameraKeys),
+                                           [this](std::uint32_t _key) {
+                                               return state_.key_down[_key];
+                                           });
+    if (camera_moving)
+        return true;
+
+    return sr_layer_ && sr_layer_->NeedsRedraw();
+}
+
 } // namespace appbase
 
 namespace {
@@ -0,0 +1,331 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. You can do whatever you want with this
+ * stuff. If we meet some day, and you think this stuff is worth it, you can
+ * buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <GL/glew.h>
+#include <GL/gl.h>
+
+#include "appbase/engine_module.h"
+#include "oglbase/error.h"
+#include "shaderunner/shaderunner.h"
+#include "uibase/mat.h"
+
+static const EGLint kConfigAttributes[] = {
+    EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_BLUE_SIZE, 8,
+    EGL_ALPHA_SIZE, 8,
+    EGL_NONE
+};
+static const EGLint kGLContextAttributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 4,
+    EGL_CONTEXT_MINOR_VERSION, 5,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifdef SR_GL_DEBUG_CONTEXT
+    EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif
+    EGL_NONE
+};
+
+static constexpr int kDefaultWidth = 1280;
+static constexpr int kDefaultHeight = 720;
+static constexpr int kDefaultFrameCount = 1;
+static constexpr float kDefaultFrameRate = 60.f;
+
+// Frames are rendered and read back in batches of kFrameBatch, through an
+// engine module a rebuilt module is swapped in between two batches.
+static constexpr int kFrameBatch = 16;
+
+static EGLDisplay GetHeadlessDisplay()
+{
+    using proc_eglGetPlatformDisplayEXT =
+        EGLDisplay(*)(EGLenum, void*, EGLint const*);
+    auto const eglGetPlatformDisplayEXT = reinterpret_cast<proc_eglGetPlatformDisplayEXT>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT")
+        );
+
+    if (eglGetPlatformDisplayEXT)
+    {
+        EGLDisplay const display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA,
+                                                            EGL_DEFAULT_DISPLAY, nullptr);
+        if (display != EGL_NO_DISPLAY)
+        {
+            std::cout << "Using surfaceless platform" << std::endl;
+            return display;
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static bool WriteFrame(std::string const& _path, int _width, int _height, std::uint8_t const* _pixels)
+{
+    std::FILE* const file = std::fopen(_path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    std::fprintf(file, "P6\n%d %d\n255\n", _width, _height);
+    std::vector<std::uint8_t> row(static_cast<std::size_t>(_width) * 3u);
+    for (int y = _height - 1; y >= 0; --y)
+    {
+        std::uint8_t const* const src = _pixels + static_cast<std::size_t>(y) * _width * 4u;
+        for (int x = 0; x < _width; ++x)
+            std::memcpy(&row[x * 3u], &src[x * 4u], 3u);
+        std::fwrite(row.data(), 1u, row.size(), file);
+    }
+    return std::fclose(file) == 0;
+}
+
+static std::string FrameName(std::string const& _output_prefix, int _frame_index)
+{
+    char frame_name[16]{};
+    std::snprintf(frame_name, sizeof(frame_name), "%06d.ppm", _frame_index);
+    return _output_prefix + frame_name;
+}
+
+// Same frames, rendered by the engine of the sr module at _module_path.
+static int RenderThroughModule(std::string const& _module_path, char const* _kernel_path,
+                               std::string const& _output_prefix, int _width, int _height,
+                               int _frame_count, float _frame_rate)
+{
+    appbase::EngineModule engine_module{ _module_path };
+    if (!engine_module.loaded())
+        return 1;
+
+    engine_module.SetResolution(_width, _height);
+    engine_module.WatchKernelFile(sr::ShaderStage::kFragment, _kernel_path);
+    engine_module.WaitKernelsBuild();
+
+    FrameDesc frame_desc{};
+    frame_desc.res[0] = static_cast<float>(_width);
+    frame_desc.res[1] = static_cast<float>(_height);
+    uibase::Mat4_t const projection_matrix = uibase::perspective(
+        0.01f, 1000.f, 3.1415926534f*0.5f,
+        static_cast<float>(_height) / static_cast<float>(_width));
+    std::copy(projection_matrix.cbegin(), projection_matrix.cend(), frame_desc.projection_matrix);
+
+    std::size_t const frame_size = static_cast<std::size_t>(_width) * _height * 4u;
+    std::vector<FrameDesc> const descs(kFrameBatch, frame_desc);
+    std::vector<float> times(kFrameBatch, 0.f);
+    std::vector<std::uint8_t> pixels(frame_size * kFrameBatch);
+
+    for (int first_frame = 0; first_frame < _frame_count; first_frame += kFrameBatch)
+    {
+        engine_module.Poll();
+
+        int const count = std::min(kFrameBatch, _frame_count - first_frame);
+        for (int i = 0; i < count; ++i)
+            times[static_cast<std::size_t>(i)] = static_cast<float>(first_frame + i) / _frame_rate;
+        if (engine_module.RenderFrames(descs.data(), times.data(), count, pixels.data()) != count)
+        {
+            std::cerr << "Frames " << first_frame << " to " << (first_frame + count - 1)
+                      << " failed" << std::endl;
+            return 1;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (!WriteFrame(FrameName(_output_prefix, first_frame + i), _width, _height,
+                            pixels.data() + frame_size * static_cast<std::size_t>(i)))
+            {
+                std::cerr << "Failed to write frame " << (first_frame + i) << std::endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Renders with the engine linked in.
+static int RenderDirect(char const* _kernel_path, std::string const& _output_prefix,
+                        int _width, int _height, int _frame_count, float _frame_rate)
+{
+    sr::RenderContext render_context{};
+    render_context.SetResolution(_width, _height);
+    render_context.projection_matrix = uibase::perspective(
+        0.01f, 1000.f, 3.1415926534f*0.5f,
+        static_cast<float>(_height) / static_cast<float>(_width));
+
+    bool kernel_reported = false;
+    bool kernel_compiled = true;
+    render_context.onFKernelCompileFinished.listeners_.emplace_back(
+        [&kernel_reported, &kernel_compiled](std::string const& _path,
+                                             sr::ErrorLogContainer const& _errorlog) {
+            for (std::pair<int, std::string> const& error : _errorlog)
+                std::cerr << _path << ":" << error.first << ": " << error.second << std::endl;
+            kernel_reported = true;
+            kernel_compiled = kernel_compiled && _errorlog.empty();
+        });
+    render_context.WatchKernelFile(sr::ShaderStage::kFragment, _kernel_path);
+    render_context.WaitKernelsBuild();
+    if (!kernel_reported || !kernel_compiled)
+    {
+        std::cerr << "Kernel build failed" << std::endl;
+        return 1;
+    }
+
+    std::size_t const frame_size = static_cast<std::size_t>(_width) * _height * 4u;
+    std::vector<float> times(kFrameBatch, 0.f);
+    std::vector<std::uint8_t> pixels(frame_size * kFrameBatch);
+
+    using StdClock = std::chrono::high_resolution_clock;
+    auto const start = StdClock::now();
+
+    for (int first_frame = 0; first_frame < _frame_count; first_frame += kFrameBatch)
+    {
+        int const count = std::min(kFrameBatch, _frame_count - first_frame);
+        for (int i = 0; i < count; ++i)
+            times[static_cast<std::size_t>(i)] = static_cast<float>(first_frame + i) / _frame_rate;
+        if (render_context.RenderFrames(times.data(), count, pixels.data()) != count)
+        {
+            std::cerr << "Frames " << first_frame << " to " << (first_frame + count - 1)
+                      << " failed" << std::endl;
+            return 1;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            if (!WriteFrame(FrameName(_output_prefix, first_frame + i), _width, _height,
+                            pixels.data() + frame_size * static_cast<std::size_t>(i)))
+            {
+                std::cerr << "Failed to write frame " << (first_frame + i) << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    float const total_time = std::chrono::duration_cast<std::chrono::duration<float>>(
+        StdClock::now() - start).count();
+    std::cout << _frame_count << " frames in " << total_time << "s" << std::endl;
+    return 0;
+}
+
+int main(int __argc, char* __argv[])
+{
+    // Optional leading "--engine-module <path>", renders through the engine
+    // of a shaderunner module rather than the one linked in.
+    std::string module_path{};
+    int arg_offset = 0;
+    if (__argc > 2 && std::strcmp(__argv[1], "--engine-module") == 0)
+    {
+        module_path = __argv[2];
+        arg_offset = 2;
+    }
+    int const arg_count = __argc - arg_offset;
+    char** const args = __argv + arg_offset;
+
+    if (arg_count < 3)
+    {
+        std::cerr << "usage: " << __argv[0]
+                  << " [--engine-module <module>] <fragment kernel> <output prefix>"
+                  << " [width height frame_count frame_rate]"
+                  << std::endl;
+        return 1;
+    }
+
+    char const* const kernel_path = args[1];
+    std::string const output_prefix = args[2];
+    int const width = (arg_count > 4) ? std::atoi(args[3]) : kDefaultWidth;
+    int const height = (arg_count > 4) ? std::atoi(args[4]) : kDefaultHeight;
+    int const frame_count = (arg_count > 5) ? std::atoi(args[5]) : kDefaultFrameCount;
+    float const frame_rate = (arg_count > 6) ? static_cast<float>(std::atof(args[6])) : kDefaultFrameRate;
+    if (width <= 0 || height <= 0 || frame_count <= 0 || frame_rate <= 0.f)
+    {
+        std::cerr << "Invalid render settings" << std::endl;
+        return 1;
+    }
+
+    EGLDisplay const display = GetHeadlessDisplay();
+    EGLint egl_major = 0, egl_minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &egl_major, &egl_minor))
+    {
+        std::cerr << "EGL initialization failed" << std::endl;
+        return 1;
+    }
+    std::cout << "EGL " << egl_major << "." << egl_minor << " was found." << std::endl;
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cerr << "Desktop OpenGL unavailable through EGL" << std::endl;
+        eglTerminate(display);
+        return 1;
+    }
+
+    EGLConfig selected_config{};
+    EGLint config_count = 0;
+    if (!eglChooseConfig(display, kConfigAttributes, &selected_config, 1, &config_count) ||
+        config_count == 0)
+    {
+        std::cerr << "No framebuffer configuration found." << std::endl;
+        eglTerminate(display);
+        return 1;
+    }
+
+    EGLContext const egl_context = eglCreateContext(display, selected_config, EGL_NO_CONTEXT,
+                                                    kGLContextAttributes);
+    if (egl_context == EGL_NO_CONTEXT)
+    {
+        std::cerr << "Modern GL context creation failed" << std::endl;
+        eglTerminate(display);
+        return 1;
+    }
+
+    // The kernel renders into its own framebuffer, no surface is ever needed.
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context))
+    {
+        std::cerr << "Surfaceless context binding failed" << std::endl;
+        eglDestroyContext(display, egl_context);
+        eglTerminate(display);
+        return 1;
+    }
+
+    glewExperimental = GL_TRUE;
+    GLenum const glew_status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (glew_status != GLEW_OK && glew_status != GLEW_ERROR_NO_GLX_DISPLAY)
+#else
+    if (glew_status != GLEW_OK)
+#endif
+    {
+        std::cerr << "glew failed to initalize." << std::endl;
+    }
+    oglbase::ClearError();
+
+	std::cout << "GL init complete : " << std::endl;
+	std::cout << "OpenGL version : " << glGetString(GL_VERSION) << std::endl;
+	std::cout << "Manufacturer : " << glGetString(GL_VENDOR) << std::endl;
+	std::cout << "Drivers : " << glGetString(GL_RENDERER) << std::endl;
+
+#ifdef SR_GL_DEBUG_CONTEXT
+    oglbase::DebugMessageControl<> debugMessageControl{};
+#endif
+
+    int const exit_code = module_path.empty()
+        ? RenderDirect(kernel_path, output_prefix, width, height, frame_count, frame_rate)
+        : RenderThroughModule(module_path, kernel_path, output_prefix,
+                              width, height, frame_count, frame_rate);
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, egl_context);
+    eglTerminate(display);
+    return exit_code;
+}
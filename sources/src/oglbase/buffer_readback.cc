@@ -0,0 +1,101 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "oglbase/buffer_readback.h"
+
+#include <algorithm>
+
+namespace oglbase {
+
+
+BufferReadback::BufferReadback() :
+	ring_{},
+	head_{ 0u }
+{
+	for (Slot &slot : ring_)
+	{
+		slot.capacity = 0;
+		slot.size = 0;
+		slot.fence = nullptr;
+	}
+}
+
+BufferReadback::~BufferReadback()
+{
+	Reset();
+}
+
+void
+BufferReadback::Capture(GLuint _buffer, GLsizeiptr _size)
+{
+	Slot &slot = ring_[head_];
+	if (slot.fence)
+		glDeleteSync(slot.fence);
+
+	if (!slot.buffer || slot.capacity < _size)
+	{
+		slot.buffer = BufferPtr{ 0u };
+		glGenBuffers(1, slot.buffer.get());
+		glBindBuffer(GL_COPY_WRITE_BUFFER, slot.buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, _size, nullptr, GL_STREAM_READ);
+		slot.capacity = _size;
+	}
+
+	glBindBuffer(GL_COPY_READ_BUFFER, _buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, slot.buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, _size);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+	slot.size = _size;
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	head_ = (head_ + 1u) % kRingSize;
+}
+
+GLsizeiptr
+BufferReadback::Read(void *o_data, GLsizeiptr _capacity)
+{
+	// Fences signal in order, oldest copy first.
+	Slot *ready = nullptr;
+	for (std::size_t i = 0; i < kRingSize; ++i)
+	{
+		Slot &slot = ring_[(head_ + i) % kRingSize];
+		if (!slot.fence)
+			continue;
+
+		GLint status = GL_UNSIGNALED;
+		glGetSynciv(slot.fence, GL_SYNC_STATUS, 1, nullptr, &status);
+		if (status != GL_SIGNALED)
+			break;
+
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+		ready = &slot;
+	}
+	if (!ready)
+		return 0;
+
+	glBindBuffer(GL_COPY_READ_BUFFER, ready->buffer);
+	glGetBufferSubData(GL_COPY_READ_BUFFER, 0, std::min(ready->size, _capacity), o_data);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+	return ready->size;
+}
+
+void
+BufferReadback::Reset()
+{
+	for (Slot &slot : ring_)
+	{
+		if (slot.fence)
+			glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+}
+
+
+} // namespace oglbase
@@ -77,6 +77,15 @@ struct FBODeleter
     }
 };
 
+struct QueryDeleter
+{
+	void operator()(GLuint _query)
+	{
+		std::cout << "gl query deleted " << _query << std::endl;
+		glDeleteQueries(1, &_query);
+	}
+};
+
 
 template struct Handle<ProgramDeleter>;
 template struct Handle<ShaderDeleter>;
@@ -84,6 +93,7 @@ template struct Handle<TextureDeleter>;
 template struct Handle<VAODeleter>;
 template struct Handle<BufferDeleter>;
 template struct Handle<FBODeleter>;
+template struct Handle<QueryDeleter>;
 
 
 } // namespace oglbase
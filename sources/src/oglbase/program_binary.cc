@@ -0,0 +1,352 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "oglbase/program_binary.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/numeric/conversion/cast.hpp>
+
+#include "utility/hash.h"
+
+namespace {
+
+static constexpr std::uint32_t kEntryMagic = 0x42505253u; // "SRPB"
+static constexpr std::uint32_t kEntryVersion = 1u;
+
+struct EntryHeader
+{
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint64_t key;
+	std::uint32_t format;
+	std::uint32_t length;
+};
+
+using SharedKeys_t = std::list<std::uint64_t>;
+
+struct SharedBinary
+{
+	GLenum format;
+	std::vector<char> binary;
+	SharedKeys_t::iterator lru_it;
+};
+
+// Process wide, shared by every ProgramBinaryCache. Keys already carry the
+// driver hash.
+struct SharedBinaries
+{
+	std::mutex mutex;
+	std::unordered_map<std::uint64_t, SharedBinary> binaries;
+	// Most recently used first.
+	SharedKeys_t lru;
+	std::size_t size = 0u;
+	std::unordered_set<std::uint64_t> claims;
+};
+
+SharedBinaries& Shared()
+{
+	static SharedBinaries shared{};
+	return shared;
+}
+
+// Expects the shared mutex to be locked.
+void
+InsertShared(SharedBinaries &_shared, std::uint64_t _key, GLenum _format, std::vector<char> &&_binary)
+{
+	auto const binary_it = _shared.binaries.find(_key);
+	if (binary_it != _shared.binaries.end())
+	{
+		_shared.size -= binary_it->second.binary.size();
+		_shared.lru.erase(binary_it->second.lru_it);
+		_shared.binaries.erase(binary_it);
+	}
+
+	_shared.size += _binary.size();
+	_shared.lru.push_front(_key);
+	_shared.binaries.emplace(_key, SharedBinary{ _format, std::move(_binary), _shared.lru.begin() });
+
+	while (_shared.size > oglbase::ProgramBinaryCache::kSharedMemoryBudget && !_shared.lru.empty())
+	{
+		auto const oldest_it = _shared.binaries.find(_shared.lru.back());
+		_shared.size -= oldest_it->second.binary.size();
+		_shared.binaries.erase(oldest_it);
+		_shared.lru.pop_back();
+	}
+}
+
+oglbase::ProgramPtr
+CreateProgram(GLenum _format, std::vector<char> const &_binary)
+{
+	oglbase::ProgramPtr result{ glCreateProgram() };
+	glProgramBinary(result, _format, _binary.data(), boost::numeric_cast<GLsizei>(_binary.size()));
+
+	GLint link_status = GL_FALSE;
+	glGetProgramiv(result, GL_LINK_STATUS, &link_status);
+	if (link_status != GL_TRUE)
+		result.reset(0u);
+	return result;
+}
+
+} // namespace
+
+namespace oglbase {
+
+namespace boostfs = ::boost::filesystem;
+
+
+ProgramBuildClaim::ProgramBuildClaim(std::uint64_t _key, bool _owned, bool _registered) :
+	key_{ _key },
+	owned_{ _owned },
+	registered_{ _registered }
+{}
+
+ProgramBuildClaim::ProgramBuildClaim(ProgramBuildClaim &&_other) :
+	key_{ _other.key_ },
+	owned_{ _other.owned_ },
+	registered_{ _other.registered_ }
+{
+	_other.owned_ = false;
+	_other.registered_ = false;
+}
+
+ProgramBuildClaim&
+ProgramBuildClaim::operator=(ProgramBuildClaim &&_other)
+{
+	if (this != &_other)
+	{
+		Release();
+		key_ = _other.key_;
+		owned_ = _other.owned_;
+		registered_ = _other.registered_;
+		_other.owned_ = false;
+		_other.registered_ = false;
+	}
+	return *this;
+}
+
+ProgramBuildClaim::~ProgramBuildClaim()
+{
+	Release();
+}
+
+void
+ProgramBuildClaim::Release()
+{
+	if (registered_)
+	{
+		SharedBinaries &shared = Shared();
+		std::lock_guard<std::mutex> const lock{ shared.mutex };
+		shared.claims.erase(key_);
+	}
+	owned_ = false;
+	registered_ = false;
+}
+
+
+ProgramBinaryCache::ProgramBinaryCache(std::string const &_directory) :
+	directory_{ _directory },
+	driver_hash_{ utility::kHashSeed },
+	enabled_{ false },
+	persistent_{ false }
+{
+	GLint format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+	if (format_count <= 0)
+	{
+		std::cout << "Program binaries unsupported, cache disabled" << std::endl;
+		return;
+	}
+
+	for (GLenum const name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		GLubyte const* const value = glGetString(name);
+		if (value)
+			driver_hash_ = utility::HashString(reinterpret_cast<char const*>(value), driver_hash_);
+	}
+
+	enabled_ = true;
+
+	if (directory_.empty())
+		return;
+
+	boost::system::error_code error{};
+	boostfs::create_directories(boostfs::path{ directory_ }, error);
+	persistent_ = boostfs::is_directory(boostfs::path{ directory_ });
+	if (!persistent_)
+		std::cout << "Program cache directory unavailable " << directory_ << std::endl;
+}
+
+
+ProgramPtr
+ProgramBinaryCache::Load(std::uint64_t _key) const
+{
+	if (!enabled_)
+		return ProgramPtr{ 0u };
+
+	std::uint64_t const key = utility::HashValue(_key, driver_hash_);
+	{
+		SharedBinaries &shared = Shared();
+		std::unique_lock<std::mutex> lock{ shared.mutex };
+		auto const binary_it = shared.binaries.find(key);
+		if (binary_it != shared.binaries.end())
+		{
+			shared.lru.splice(shared.lru.begin(), shared.lru, binary_it->second.lru_it);
+			GLenum const format = binary_it->second.format;
+			std::vector<char> const binary = binary_it->second.binary;
+			lock.unlock();
+
+			ProgramPtr result = CreateProgram(format, binary);
+			if (!result)
+				std::cout << "Shared program refused by the driver" << std::endl;
+			return result;
+		}
+	}
+
+	if (!persistent_)
+		return ProgramPtr{ 0u };
+
+	std::ifstream file_stream{ EntryPath(key), std::ios_base::in | std::ios_base::binary };
+	if (!file_stream)
+		return ProgramPtr{ 0u };
+
+	EntryHeader header{};
+	file_stream.read(reinterpret_cast<char*>(&header), sizeof(EntryHeader));
+	if (!file_stream ||
+		header.magic != kEntryMagic ||
+		header.version != kEntryVersion ||
+		header.key != key)
+	{
+		std::cout << "Program cache entry rejected" << std::endl;
+		return ProgramPtr{ 0u };
+	}
+
+	std::vector<char> binary(header.length);
+	file_stream.read(binary.data(), boost::numeric_cast<std::streamsize>(binary.size()));
+	if (!file_stream)
+	{
+		std::cout << "Program cache entry truncated" << std::endl;
+		return ProgramPtr{ 0u };
+	}
+
+	ProgramPtr result = CreateProgram(static_cast<GLenum>(header.format), binary);
+	if (!result)
+	{
+		std::cout << "Program cache entry refused by the driver" << std::endl;
+		return result;
+	}
+
+	SharedBinaries &shared = Shared();
+	std::lock_guard<std::mutex> const lock{ shared.mutex };
+	InsertShared(shared, key, static_cast<GLenum>(header.format), std::move(binary));
+	return result;
+}
+
+
+void
+ProgramBinaryCache::Store(std::uint64_t _key, GLuint _program) const
+{
+	if (!enabled_ || !_program)
+		return;
+
+	GLint binary_length = 0;
+	glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+	if (binary_length <= 0)
+		return;
+
+	std::vector<char> binary(boost::numeric_cast<std::size_t>(binary_length));
+	GLenum format = 0u;
+	GLsizei written = 0;
+	glGetProgramBinary(_program, binary_length, &written, &format, binary.data());
+	if (written <= 0)
+		return;
+	binary.resize(static_cast<std::size_t>(written));
+
+	std::uint64_t const key = utility::HashValue(_key, driver_hash_);
+	{
+		SharedBinaries &shared = Shared();
+		std::lock_guard<std::mutex> const lock{ shared.mutex };
+		InsertShared(shared, key, format, std::vector<char>{ binary });
+	}
+
+	if (!persistent_)
+		return;
+
+	EntryHeader const header{
+		kEntryMagic,
+		kEntryVersion,
+		key,
+		static_cast<std::uint32_t>(format),
+		boost::numeric_cast<std::uint32_t>(written)
+	};
+
+	// Written aside then renamed, a concurrent Load never sees a partial entry.
+	std::string const path = EntryPath(key);
+	std::string const temp_path = path + ".tmp";
+	{
+		std::ofstream file_stream{ temp_path,
+				std::ios_base::out | std::ios_base::binary | std::ios_base::trunc };
+		file_stream.write(reinterpret_cast<char const*>(&header), sizeof(EntryHeader));
+		file_stream.write(binary.data(), static_cast<std::streamsize>(written));
+		if (!file_stream)
+		{
+			std::cout << "Program cache write failed " << temp_path << std::endl;
+			return;
+		}
+	}
+	std::rename(temp_path.c_str(), path.c_str());
+}
+
+
+ProgramBuildClaim
+ProgramBinaryCache::Claim(std::uint64_t _key) const
+{
+	// Without binaries there is nothing to wait for, every context builds.
+	if (!enabled_)
+		return ProgramBuildClaim{ _key, true, false };
+
+	std::uint64_t const key = utility::HashValue(_key, driver_hash_);
+	SharedBinaries &shared = Shared();
+	std::lock_guard<std::mutex> const lock{ shared.mutex };
+	bool const owned = shared.claims.insert(key).second;
+	return ProgramBuildClaim{ key, owned, owned };
+}
+
+
+bool
+ProgramBinaryCache::Claimed(std::uint64_t _key) const
+{
+	if (!enabled_)
+		return false;
+
+	std::uint64_t const key = utility::HashValue(_key, driver_hash_);
+	SharedBinaries &shared = Shared();
+	std::lock_guard<std::mutex> const lock{ shared.mutex };
+	return shared.claims.count(key) != 0u;
+}
+
+
+std::string
+ProgramBinaryCache::EntryPath(std::uint64_t _key) const
+{
+	char name[17]{};
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(_key));
+	return (boostfs::path{ directory_ } / (std::string(name) + ".bin")).generic_string();
+}
+
+
+} // namespace oglbase
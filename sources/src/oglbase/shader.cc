@@ -19,39 +19,103 @@ namespace oglbase {
 
 ShaderPtr
 CompileShader(GLenum _type, ShaderSources_t const&_sources, std::string *o_log)
+{
+	ShaderPtr result = BeginCompileShader(_type, _sources);
+	EndCompileShader(result, o_log);
+	return result;
+}
+
+
+
+ProgramPtr
+LinkProgram(ShaderBinaries_t const &_binaries, bool _retrievable_binary)
+{
+	ProgramPtr result = BeginLinkProgram(_binaries, _retrievable_binary);
+	EndLinkProgram(result);
+	return result;
+}
+
+
+void
+EnableParallelShaderCompile()
+{
+	if (GLEW_KHR_parallel_shader_compile)
+		glMaxShaderCompilerThreadsKHR(0xffffffffu);
+}
+
+
+ShaderPtr
+BeginCompileShader(GLenum _type, ShaderSources_t const&_sources)
 {
 	GLsizei const source_count = boost::numeric_cast<GLsizei>(_sources.size());
 	ShaderPtr result{ glCreateShader(_type) };
 	glShaderSource(result, source_count, _sources.data(), NULL);
 	glCompileShader(result);
-	if (GetShaderStatus<ShaderInfoFuncs, GL_COMPILE_STATUS>(result))
+	return result;
+}
+
+bool
+IsShaderReady(GLuint _shader)
+{
+	if (!GLEW_KHR_parallel_shader_compile)
+		return true;
+	GLint completed = GL_FALSE;
+	glGetShaderiv(_shader, GL_COMPLETION_STATUS_KHR, &completed);
+	return completed == GL_TRUE;
+}
+
+bool
+EndCompileShader(ShaderPtr &_shader, std::string *o_log)
+{
+	if (GetShaderStatus<ShaderInfoFuncs, GL_COMPILE_STATUS>(_shader))
 	{
-        std::string log = GetShaderLog<ShaderInfoFuncs>(result);
+        std::string log = GetShaderLog<ShaderInfoFuncs>(_shader);
         InsertDebugMessage(log);
         if (o_log)
             std::swap(log, *o_log);
-		result.reset(0u);
+		_shader.reset(0u);
+		return false;
 	}
-	return result;
+	return true;
 }
 
 
-
 ProgramPtr
-LinkProgram(ShaderBinaries_t const &_binaries)
+BeginLinkProgram(ShaderBinaries_t const &_binaries, bool _retrievable_binary)
 {
 	ProgramPtr result{ glCreateProgram() };
+	if (_retrievable_binary)
+		glProgramParameteri(result, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	std::for_each(_binaries.cbegin(), _binaries.cend(), [&result](GLuint _shader) {
 		glAttachShader(result, _shader);
 	});
 	glLinkProgram(result);
-	if (GetShaderStatus<ProgramInfoFuncs, GL_LINK_STATUS>(result))
+	return result;
+}
+
+bool
+IsProgramReady(GLuint _program)
+{
+	if (!GLEW_KHR_parallel_shader_compile)
+		return true;
+	GLint completed = GL_FALSE;
+	glGetProgramiv(_program, GL_COMPLETION_STATUS_KHR, &completed);
+	return completed == GL_TRUE;
+}
+
+bool
+EndLinkProgram(ProgramPtr &_program, std::string *o_log)
+{
+	if (GetShaderStatus<ProgramInfoFuncs, GL_LINK_STATUS>(_program))
 	{
-        std::string log = GetShaderLog<ProgramInfoFuncs>(result);
+        std::string log = GetShaderLog<ProgramInfoFuncs>(_program);
         InsertDebugMessage(log);
-		result.reset(0u);
+        if (o_log)
+            std::swap(log, *o_log);
+		_program.reset(0u);
+		return false;
 	}
-	return result;
+	return true;
 }
 
 
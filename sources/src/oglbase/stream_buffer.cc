@@ -0,0 +1,105 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "oglbase/stream_buffer.h"
+
+#include <algorithm>
+
+namespace {
+
+static constexpr GLuint64 kFenceTimeout = 1000000000ull;
+static constexpr std::size_t kMinRegionSize = 256u;
+
+} // namespace
+
+namespace oglbase {
+
+
+StreamBuffer::StreamBuffer() :
+	buffer_{ 0u },
+	mapping_{ nullptr },
+	region_size_{ 0u },
+	region_{ 0u },
+	fences_{}
+{}
+
+StreamBuffer::~StreamBuffer()
+{
+	ClearFences();
+}
+
+void*
+StreamBuffer::Write(std::size_t _size)
+{
+	if (_size > region_size_)
+	{
+		std::size_t region_size = std::max(region_size_, kMinRegionSize);
+		while (region_size < _size)
+			region_size *= 2u;
+		Allocate(region_size);
+	}
+	else
+	{
+		region_ = (region_ + 1u) % kRegionCount;
+		GLsync &fence = fences_[region_];
+		if (fence)
+		{
+			glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeout);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	return static_cast<char*>(mapping_) + offset();
+}
+
+void
+StreamBuffer::Fence()
+{
+	GLsync &fence = fences_[region_];
+	if (fence)
+		glDeleteSync(fence);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void
+StreamBuffer::Allocate(std::size_t _region_size)
+{
+	// The previous storage stays alive until the GPU is done with it, the
+	// driver takes care of that on deletion.
+	ClearFences();
+
+	GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	BufferPtr buffer{ 0u };
+	glGenBuffers(1, buffer.get());
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(_region_size * kRegionCount),
+	                nullptr, flags);
+	mapping_ = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0,
+	                            static_cast<GLsizeiptr>(_region_size * kRegionCount), flags);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+
+	buffer_ = std::move(buffer);
+	region_size_ = _region_size;
+	region_ = 0u;
+}
+
+void
+StreamBuffer::ClearFences()
+{
+	for (GLsync &fence : fences_)
+	{
+		if (fence)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+
+} // namespace oglbase
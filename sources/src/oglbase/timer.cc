@@ -0,0 +1,81 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "oglbase/timer.h"
+
+namespace oglbase {
+
+
+GPUTimer::GPUTimer() :
+	ring_{},
+	head_{ 0u },
+	tail_{ 0u },
+	recording_{ false },
+	elapsed_{ 0.f },
+	sample_count_{ 0u }
+{
+	for (Sample &sample : ring_)
+	{
+		glGenQueries(1, sample.start.get());
+		glGenQueries(1, sample.end.get());
+		sample.count = 1;
+		sample.pending = false;
+	}
+}
+
+void
+GPUTimer::Begin()
+{
+	Collect();
+
+	Sample &sample = ring_[head_];
+	recording_ = !sample.pending;
+	if (recording_)
+		glQueryCounter(sample.start, GL_TIMESTAMP);
+}
+
+void
+GPUTimer::End(int _count)
+{
+	if (!recording_)
+		return;
+
+	Sample &sample = ring_[head_];
+	glQueryCounter(sample.end, GL_TIMESTAMP);
+	sample.count = (_count > 0) ? _count : 1;
+	sample.pending = true;
+	head_ = (head_ + 1u) % kRingSize;
+	recording_ = false;
+}
+
+void
+GPUTimer::Collect()
+{
+	while (ring_[tail_].pending)
+	{
+		Sample &sample = ring_[tail_];
+
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(sample.end, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE)
+			break;
+
+		GLuint64 start = 0u, end = 0u;
+		glGetQueryObjectui64v(sample.start, GL_QUERY_RESULT, &start);
+		glGetQueryObjectui64v(sample.end, GL_QUERY_RESULT, &end);
+		elapsed_ = static_cast<float>(end - start) * 1e-9f / static_cast<float>(sample.count);
+		++sample_count_;
+
+		sample.pending = false;
+		tail_ = (tail_ + 1u) % kRingSize;
+	}
+}
+
+
+} // namespace oglbase
@@ -0,0 +1,62 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "oglbase/uniform.h"
+
+#include <vector>
+
+#include <boost/numeric/conversion/cast.hpp>
+
+namespace oglbase {
+
+
+UniformTable_t
+ReflectUniforms(GLuint _program)
+{
+	UniformTable_t result{};
+	if (!_program)
+		return result;
+
+	GLint uniform_count = 0;
+	glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &uniform_count);
+	GLint name_max_length = 0;
+	glGetProgramiv(_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &name_max_length);
+
+	std::vector<GLchar> name_buffer(boost::numeric_cast<std::size_t>(name_max_length) + 1u, '\0');
+	result.reserve(boost::numeric_cast<std::size_t>(uniform_count));
+	for (GLint uniform_index = 0; uniform_index < uniform_count; ++uniform_index)
+	{
+		GLsizei name_length = 0;
+		UniformDesc desc{ -1, 0u, 0 };
+		glGetActiveUniform(_program, static_cast<GLuint>(uniform_index),
+						   static_cast<GLsizei>(name_buffer.size()), &name_length,
+						   &desc.size, &desc.type, name_buffer.data());
+
+		std::string name{ name_buffer.data(), boost::numeric_cast<std::size_t>(name_length) };
+		std::size_t const subscript = name.find('[');
+		if (subscript != std::string::npos)
+			name.resize(subscript);
+
+		desc.location = glGetUniformLocation(_program, name_buffer.data());
+		if (desc.location >= 0)
+			result.emplace(std::move(name), desc);
+	}
+
+	return result;
+}
+
+GLint
+FindUniform(UniformTable_t const &_table, char const *_name)
+{
+	auto const it = _table.find(std::string{ _name });
+	return (it != _table.cend()) ? it->second.location : -1;
+}
+
+
+} // namespace oglbase
@@ -0,0 +1,242 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "shaderunner/kernel_preprocessor.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+
+#include "utility/file.h"
+
+namespace sr {
+
+namespace boostfs = ::boost::filesystem;
+
+
+void
+PreprocessedKernel::RemapErrorLog(ErrorLogContainer &_errorlog) const
+{
+	for (std::pair<int, std::string> &error : _errorlog)
+	{
+		if (error.first < 1 || error.first > static_cast<int>(line_map.size()))
+			continue;
+
+		Line const &origin = line_map[static_cast<std::size_t>(error.first - 1)];
+		if (origin.file == 0)
+		{
+			error.first = origin.line;
+		}
+		else
+		{
+			error.first = origin.kernel_line;
+			error.second = files[static_cast<std::size_t>(origin.file)] +
+				"(" + std::to_string(origin.line) + "): " + error.second;
+		}
+	}
+}
+
+
+void
+KernelPreprocessor::AddSearchPath(std::string const &_path)
+{
+	search_paths_.push_back(utility::File{ _path }.path());
+	// Includes were resolved against the previous search paths.
+	files_.clear();
+}
+
+
+PreprocessedKernel
+KernelPreprocessor::Process(std::string const &_path, std::string const &_source)
+{
+	// The kernel file itself is always parsed again, it is only kept for
+	// Dependents to see its includes.
+	ParsedFile &kernel_file = files_[_path];
+	kernel_file = Parse(_path, _source);
+
+	PreprocessedKernel result{};
+	result.source.reserve(_source.size());
+	result.files.push_back(_path);
+	Expand(kernel_file, 0, 0, result);
+	return result;
+}
+
+
+bool
+KernelPreprocessor::Refresh(std::string const &_path)
+{
+	auto const file_it = files_.find(_path);
+	if (file_it == files_.end())
+		return true;
+
+	utility::File file{ _path };
+	if (!file.Exists())
+	{
+		files_.erase(file_it);
+		return true;
+	}
+
+	std::string const source = file.ReadAll();
+	if (utility::HashString(source) == file_it->second.content_hash)
+		return false;
+
+	file_it->second = Parse(_path, source);
+	return true;
+}
+
+
+std::set<std::string>
+KernelPreprocessor::Dependents(std::string const &_path) const
+{
+	std::set<std::string> result{};
+	std::vector<std::string> pending{ _path };
+	while (!pending.empty())
+	{
+		std::string const path = std::move(pending.back());
+		pending.pop_back();
+
+		for (auto const &file : files_)
+		{
+			bool const includes_path = std::any_of(file.second.includes.cbegin(), file.second.includes.cend(),
+			                                       [&path](Include const& _include) {
+				                                       return _include.path == path;
+			                                       });
+			if (includes_path && result.insert(file.first).second)
+				pending.push_back(file.first);
+		}
+	}
+	return result;
+}
+
+
+bool
+KernelPreprocessor::ParseInclude(std::string const &_line, std::string *o_name, bool *o_angled)
+{
+	static char const kDirective[] = "include";
+	static std::size_t const kDirectiveLength = std::strlen(kDirective);
+
+	std::size_t begin = _line.find_first_not_of(" \t");
+	if (begin == std::string::npos || _line[begin] != '#')
+		return false;
+	begin = _line.find_first_not_of(" \t", begin + 1);
+	if (begin == std::string::npos || _line.compare(begin, kDirectiveLength, kDirective) != 0)
+		return false;
+	begin = _line.find_first_not_of(" \t", begin + kDirectiveLength);
+	if (begin == std::string::npos || (_line[begin] != '"' && _line[begin] != '<'))
+		return false;
+
+	*o_angled = (_line[begin] == '<');
+	std::size_t const end = _line.find(*o_angled ? '>' : '"', begin + 1);
+	if (end == std::string::npos)
+		return false;
+
+	*o_name = _line.substr(begin + 1, end - begin - 1);
+	return true;
+}
+
+
+KernelPreprocessor::ParsedFile
+KernelPreprocessor::Parse(std::string const &_path, std::string const &_source) const
+{
+	ParsedFile result{ utility::HashString(_source), {}, {} };
+
+	std::istringstream stream{ _source };
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		std::string name;
+		bool angled = false;
+		if (ParseInclude(line, &name, &angled))
+		{
+			result.includes.push_back(Include{ result.lines.size(), name, Resolve(_path, name, angled) });
+			line.clear();
+		}
+		result.lines.push_back(std::move(line));
+	}
+	return result;
+}
+
+
+std::string
+KernelPreprocessor::Resolve(std::string const &_including_path, std::string const &_name, bool _angled) const
+{
+	std::vector<boostfs::path> candidates{};
+	if (!_angled)
+		candidates.push_back(boostfs::path{ _including_path }.parent_path() / _name);
+	for (std::string const &search_path : search_paths_)
+		candidates.push_back(boostfs::path{ search_path } / _name);
+
+	for (boostfs::path const &candidate : candidates)
+	{
+		if (boostfs::is_regular_file(candidate))
+			return utility::File{ candidate.lexically_normal().generic_string() }.path();
+	}
+	return std::string{};
+}
+
+
+KernelPreprocessor::ParsedFile const *
+KernelPreprocessor::Load(std::string const &_path)
+{
+	auto const file_it = files_.find(_path);
+	if (file_it != files_.end())
+		return &file_it->second;
+
+	utility::File file{ _path };
+	if (!file.Exists())
+		return nullptr;
+
+	ParsedFile &result = files_[_path];
+	result = Parse(_path, file.ReadAll());
+	return &result;
+}
+
+
+void
+KernelPreprocessor::Expand(ParsedFile const &_file, int _file_index, int _kernel_line,
+                           PreprocessedKernel &_result)
+{
+	auto include_it = _file.includes.cbegin();
+	for (std::size_t line_index = 0u; line_index < _file.lines.size(); ++line_index)
+	{
+		int const kernel_line = (_file_index == 0) ? static_cast<int>(line_index + 1u) : _kernel_line;
+
+		if (include_it != _file.includes.cend() && include_it->line == line_index)
+		{
+			Include const &include = *include_it++;
+			bool const expanded = std::find(_result.files.cbegin(), _result.files.cend(),
+			                                include.path) != _result.files.cend();
+			ParsedFile const *included_file = (include.path.empty() || expanded) ? nullptr : Load(include.path);
+			if (included_file)
+			{
+				_result.files.push_back(include.path);
+				Expand(*included_file, static_cast<int>(_result.files.size() - 1u), kernel_line, _result);
+				continue;
+			}
+
+			if (!expanded)
+			{
+				std::cout << "Cannot open include file " << include.name << std::endl;
+				_result.errors.emplace_back(kernel_line, "cannot open include file \"" + include.name + "\"");
+			}
+		}
+
+		_result.source += _file.lines[line_index];
+		_result.source += '\n';
+		_result.line_map.push_back(PreprocessedKernel::Line{
+			_file_index, static_cast<int>(line_index + 1u), kernel_line
+		});
+	}
+}
+
+
+} // namespace sr
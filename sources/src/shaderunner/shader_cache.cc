@@ -39,10 +39,21 @@ KernelSuffix(ShaderStage _stage)
 		static oglbase::ShaderSources_t const kKernelSuffix{
 			"\n",
 			SR_SL_ENTRY_POINT(SR_FRAG_ENTRY_POINT),
+			#include "shaders/temporal_hits.h"
 			#include "shaders/entry_point.frag.h"
 		};
 		return kKernelSuffix;
 	}
+	case ShaderStage::kCompute:
+	{
+		static oglbase::ShaderSources_t const kKernelSuffix{
+			"\n",
+			SR_SL_ENTRY_POINT(SR_FRAG_ENTRY_POINT),
+			#include "shaders/temporal_hits.h"
+			#include "shaders/entry_point.comp.h"
+		};
+		return kKernelSuffix;
+	}
 	default:
 	{
 		static oglbase::ShaderSources_t const kEmptySuffix{};
@@ -86,6 +97,7 @@ ShaderStageToGLenum(ShaderStage _stage)
 	case ShaderStage::kVertex: return GL_VERTEX_SHADER;
 	case ShaderStage::kFragment: return GL_FRAGMENT_SHADER;
     case ShaderStage::kGeometry: return GL_GEOMETRY_SHADER;
+	case ShaderStage::kCompute: return GL_COMPUTE_SHADER;
 	default: return static_cast<GLenum>(0u);
 	}
 }
@@ -120,5 +132,103 @@ ShaderCache::operator[](ShaderStage _stage) const
 	return cached_shaders_[static_cast<std::size_t>(_stage)];
 }
 
+void
+ShaderCache::Install(ShaderStage _stage, oglbase::ShaderPtr &&_shader, utility::Hash_t _key)
+{
+	std::size_t const index = static_cast<std::size_t>(_stage);
+	if (cached_shaders_[index] && cached_keys_[index])
+		RetireShader(cached_keys_[index], std::move(cached_shaders_[index]));
+	cached_shaders_[index] = std::move(_shader);
+	cached_keys_[index] = _key;
+}
+
+void
+ShaderCache::RetireShader(utility::Hash_t _key, oglbase::ShaderPtr &&_shader)
+{
+	if (!_shader)
+		return;
+	GLint source_length = 0;
+	glGetShaderiv(_shader, GL_SHADER_SOURCE_LENGTH, &source_length);
+	Retire(retired_shaders_, Retired{ _key, std::move(_shader), oglbase::ProgramPtr{ 0u },
+									  static_cast<std::size_t>(std::max(source_length, 1)) });
+}
+
+void
+ShaderCache::RetireProgram(utility::Hash_t _key, oglbase::ProgramPtr &&_program)
+{
+	if (!_program)
+		return;
+	GLint binary_length = 0;
+	glGetProgramiv(_program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+	Retire(retired_programs_, Retired{ _key, oglbase::ShaderPtr{ 0u }, std::move(_program),
+									   static_cast<std::size_t>(std::max(binary_length, 1)) });
+}
+
+oglbase::ShaderPtr
+ShaderCache::TakeShader(utility::Hash_t _key)
+{
+	auto const index_it = retired_shaders_.find(_key);
+	if (index_it == retired_shaders_.end())
+		return oglbase::ShaderPtr{ 0u };
+
+	oglbase::ShaderPtr result = std::move(index_it->second->shader);
+	retired_size_ -= index_it->second->size;
+	retired_.erase(index_it->second);
+	retired_shaders_.erase(index_it);
+	return result;
+}
+
+oglbase::ProgramPtr
+ShaderCache::TakeProgram(utility::Hash_t _key)
+{
+	auto const index_it = retired_programs_.find(_key);
+	if (index_it == retired_programs_.end())
+		return oglbase::ProgramPtr{ 0u };
+
+	oglbase::ProgramPtr result = std::move(index_it->second->program);
+	retired_size_ -= index_it->second->size;
+	retired_.erase(index_it->second);
+	retired_programs_.erase(index_it);
+	return result;
+}
+
+void
+ShaderCache::SetMemoryBudget(std::size_t _bytes)
+{
+	memory_budget_ = _bytes;
+	Trim();
+}
+
+void
+ShaderCache::Retire(RetiredIndex_t &_index, Retired &&_retired)
+{
+	// The same content retired twice, the older copy goes.
+	auto const index_it = _index.find(_retired.key);
+	if (index_it != _index.end())
+	{
+		retired_size_ -= index_it->second->size;
+		retired_.erase(index_it->second);
+		_index.erase(index_it);
+	}
+
+	retired_size_ += _retired.size;
+	retired_.push_front(std::move(_retired));
+	_index.emplace(retired_.front().key, retired_.begin());
+	Trim();
+}
+
+void
+ShaderCache::Trim()
+{
+	while (retired_size_ > memory_budget_ && !retired_.empty())
+	{
+		Retired &oldest = retired_.back();
+		RetiredIndex_t &index = oldest.program ? retired_programs_ : retired_shaders_;
+		index.erase(oldest.key);
+		retired_size_ -= oldest.size;
+		retired_.pop_back();
+	}
+}
+
 
 } // namespace sr
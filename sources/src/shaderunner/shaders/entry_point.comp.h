@@ -0,0 +1,65 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+R"__SR_SS__(
+
+layout(local_size_x = SR_WORKGROUP_SIZE_X, local_size_y = SR_WORKGROUP_SIZE_Y) in;
+layout(rgba16f, binding = 0) writeonly uniform image2D kernel_output;
+// Pixel rectangle of the dispatch, origin then size.
+uniform ivec4 iComputeRect;
+
+uint sr_CompactBits(uint x)
+{
+	x &= 0x55555555u;
+	x = (x ^ (x >> 1u)) & 0x33333333u;
+	x = (x ^ (x >> 2u)) & 0x0f0f0f0fu;
+	x = (x ^ (x >> 4u)) & 0x00ff00ffu;
+	x = (x ^ (x >> 8u)) & 0x0000ffffu;
+	return x;
+}
+
+// Tile of the workgroup_index-th workgroup, in workgroups.
+uvec2 sr_WorkgroupTile(uint workgroup_index, uint columns)
+{
+#if SR_MORTON_ORDER
+	uint block_columns = (columns + SR_MORTON_BLOCK_SIZE - 1u) / SR_MORTON_BLOCK_SIZE;
+	uint block = workgroup_index / (SR_MORTON_BLOCK_SIZE * SR_MORTON_BLOCK_SIZE);
+	uint block_index = workgroup_index % (SR_MORTON_BLOCK_SIZE * SR_MORTON_BLOCK_SIZE);
+	return uvec2(block % block_columns, block / block_columns) * SR_MORTON_BLOCK_SIZE +
+		uvec2(sr_CompactBits(block_index), sr_CompactBits(block_index >> 1u));
+#else
+	return uvec2(workgroup_index % columns, workgroup_index / columns);
+#endif
+}
+
+void main()
+{
+	uint columns = (uint(iComputeRect.z) + gl_WorkGroupSize.x - 1u) / gl_WorkGroupSize.x;
+	uint workgroup_index = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+	uvec2 tile = sr_WorkgroupTile(workgroup_index, columns);
+	ivec2 texel = iComputeRect.xy + ivec2(tile * gl_WorkGroupSize.xy + gl_LocalInvocationID.xy);
+	if (any(greaterThanEqual(texel, iComputeRect.xy + iComputeRect.zw)))
+		return;
+
+	vec4 frag_color = vec4(0.0);
+	vec2 frag_coord = vec2(texel) + vec2(0.5) + iJitter;
+#ifdef SR_TEMPORAL_HITS
+	sr_texel = texel;
+#endif
+	SR_ENTRY_POINT(frag_color, frag_coord);
+	imageStore(kernel_output, texel, frag_color);
+#ifdef SR_COST_PROFILING
+	sr_StoreCost(texel);
+#endif
+#ifdef SR_TEMPORAL_HITS
+	imageStore(sr_hit_image, texel, sr_hit);
+#endif
+}
+
+)__SR_SS__"
@@ -14,8 +14,21 @@ layout(location = 0) out vec4 frag_color;
 void main()
 {
 	frag_color = vec4(0.0);
-	vec2 frag_coord = (gl_FragCoord).xy;
+#ifdef SR_DEPTH_PREPASS
+	vec2 frag_coord = (gl_FragCoord).xy * iPrepassTileSize;
+#else
+	vec2 frag_coord = (gl_FragCoord).xy + iJitter;
+#endif
+#ifdef SR_TEMPORAL_HITS
+	sr_texel = ivec2(gl_FragCoord.xy);
+#endif
 	SR_ENTRY_POINT(frag_color, frag_coord);
+#ifdef SR_COST_PROFILING
+	sr_StoreCost(ivec2(gl_FragCoord.xy));
+#endif
+#ifdef SR_TEMPORAL_HITS
+	imageStore(sr_hit_image, sr_texel, sr_hit);
+#endif
 }
 
 )__SR_SS__"
@@ -0,0 +1,17 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+R"__SR_SS__(
+
+#ifndef SR_TEMPORAL_HITS
+float srRayStart(vec3 ray_origin, vec3 ray_direction) { return 0.0; }
+void srSetHit(vec3 ray_origin, vec3 ray_direction, float hit_distance) {}
+#endif
+
+)__SR_SS__"
@@ -11,33 +11,77 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cctype>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <set>
+#include <sstream>
 #include <unordered_map>
 #include <vector>
 
+#include <boost/filesystem.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 #include <GL/glew.h>
 
 #include "utility/file.h"
+#include "utility/file_watcher.h"
 #include "utility/clock.h"
+#include "utility/hash.h"
 
+#include "oglbase/buffer_readback.h"
 #include "oglbase/error.h"
+#include "oglbase/framebuffer.h"
 #include "oglbase/handle.h"
+#include "oglbase/program_binary.h"
 #include "oglbase/shader.h"
+#include "oglbase/stream_buffer.h"
+#include "oglbase/timer.h"
+#include "oglbase/uniform.h"
 
-#define SR_GLSL_VERSION "#version 330 core\n"
+#include "shaderunner/kernel_preprocessor.h"
+
+#define SR_GLSL_VERSION "#version 430 core\n"
 #define SR_SL_TIME_UNIFORM "iTime"
 #define SR_SL_RESOLUTION_UNIFORM "iResolution"
+#define SR_SL_JITTER_UNIFORM "iJitter"
 
 #define SR_SL_PROJMAT_UNIFORM "iProjMat"
+#define SR_SL_INV_PROJMAT_UNIFORM "iInvProjMat"
+#define SR_SL_FRAME_BLOCK "SRFrame"
+#define SR_FRAME_BINDING 0
 
-#define SR_SL_GIZMOS_UNIFORM "iGizmos"
-#define SR_SL_GIZMOS_MAX "16"
+#define SR_SL_GIZMOS_BUFFER "iGizmos"
+#define SR_SL_GIZMO_PARAMS_BUFFER "iGizmoParams"
 #define SR_SL_GIZMO_COUNT_UNIFORM "iGizmoCount"
+#define SR_GIZMOS_BINDING 0
+#define SR_GIZMO_PARAMS_BINDING 1
+#define SR_SL_COST_MACRO "SR_COST"
+#define SR_COST_BINDING 2
+#define SR_COST_IMAGE_UNIT 1
+#define SR_COST_TILE_SIZE 32
+#define SR_SL_PREV_PROJMAT_UNIFORM "iPrevProjMat"
+#define SR_SL_PREV_HITS_UNIFORM "iPrevHits"
+#define SR_HITS_IMAGE_UNIT 2
+#define SR_PREV_HITS_TEXTURE_UNIT 4
+#define SR_SL_RAY_START_UNIFORM "iRayStart"
+#define SR_SL_PREPASS_TILE_UNIFORM "iPrepassTileSize"
+#define SR_RAY_START_TEXTURE_UNIT 5
+#define SR_STRINGIFY_(x) #x
+#define SR_STRINGIFY(x) SR_STRINGIFY_(x)
+
+#define SR_SL_CHANNEL_UNIFORM "iChannel"
+#define SR_SL_COMPUTE_RECT_UNIFORM "iComputeRect"
+#define SR_SL_PASS_PRAGMA "#pragma sr_pass"
+
+// Linked programs are persisted there, an empty path disables the cache.
+#ifndef SR_PROGRAM_CACHE_DIR
+#define SR_PROGRAM_CACHE_DIR "sr_cache"
+#endif
 
 /* [ DESIGN DRAFT ]
  * [X] utility
@@ -151,34 +195,653 @@ static std::vector<float> const& kTempPointVector()
 
 namespace sr {
 
+namespace boostfs = ::boost::filesystem;
+
 using Resolution_t = std::array<float, 2>;
+using Jitter_t = std::array<float, 2>;
+static Jitter_t const kNoJitter{ 0.f, 0.f };
+
+// One call whatever the uniform type, to the program in use.
+static void
+UploadUniform(GLint _location, UniformType _type, void const *_data)
+{
+    GLfloat const *floats = static_cast<GLfloat const*>(_data);
+    GLint const *ints = static_cast<GLint const*>(_data);
+    switch (_type)
+    {
+    case UniformType::kFloat: glUniform1fv(_location, 1, floats); break;
+    case UniformType::kVec2: glUniform2fv(_location, 1, floats); break;
+    case UniformType::kVec3: glUniform3fv(_location, 1, floats); break;
+    case UniformType::kVec4: glUniform4fv(_location, 1, floats); break;
+    case UniformType::kInt: case UniformType::kBool: glUniform1iv(_location, 1, ints); break;
+    case UniformType::kIVec2: glUniform2iv(_location, 1, ints); break;
+    case UniformType::kIVec3: glUniform3iv(_location, 1, ints); break;
+    case UniformType::kIVec4: glUniform4iv(_location, 1, ints); break;
+    case UniformType::kMat3: glUniformMatrix3fv(_location, 1, GL_FALSE, floats); break;
+    case UniformType::kMat4: glUniformMatrix4fv(_location, 1, GL_FALSE, floats); break;
+    default: break;
+    }
+}
+
+// General 4x4 inverse, identity for singular matrices.
+static Mat4_t
+InverseMatrix(Mat4_t const &_m)
+{
+    Mat4_t inverse{
+        _m[5] * _m[10] * _m[15] - _m[5] * _m[11] * _m[14] - _m[9] * _m[6] * _m[15] +
+            _m[9] * _m[7] * _m[14] + _m[13] * _m[6] * _m[11] - _m[13] * _m[7] * _m[10],
+        -_m[1] * _m[10] * _m[15] + _m[1] * _m[11] * _m[14] + _m[9] * _m[2] * _m[15] -
+            _m[9] * _m[3] * _m[14] - _m[13] * _m[2] * _m[11] + _m[13] * _m[3] * _m[10],
+        _m[1] * _m[6] * _m[15] - _m[1] * _m[7] * _m[14] - _m[5] * _m[2] * _m[15] +
+            _m[5] * _m[3] * _m[14] + _m[13] * _m[2] * _m[7] - _m[13] * _m[3] * _m[6],
+        -_m[1] * _m[6] * _m[11] + _m[1] * _m[7] * _m[10] + _m[5] * _m[2] * _m[11] -
+            _m[5] * _m[3] * _m[10] - _m[9] * _m[2] * _m[7] + _m[9] * _m[3] * _m[6],
+        -_m[4] * _m[10] * _m[15] + _m[4] * _m[11] * _m[14] + _m[8] * _m[6] * _m[15] -
+            _m[8] * _m[7] * _m[14] - _m[12] * _m[6] * _m[11] + _m[12] * _m[7] * _m[10],
+        _m[0] * _m[10] * _m[15] - _m[0] * _m[11] * _m[14] - _m[8] * _m[2] * _m[15] +
+            _m[8] * _m[3] * _m[14] + _m[12] * _m[2] * _m[11] - _m[12] * _m[3] * _m[10],
+        -_m[0] * _m[6] * _m[15] + _m[0] * _m[7] * _m[14] + _m[4] * _m[2] * _m[15] -
+            _m[4] * _m[3] * _m[14] - _m[12] * _m[2] * _m[7] + _m[12] * _m[3] * _m[6],
+        _m[0] * _m[6] * _m[11] - _m[0] * _m[7] * _m[10] - _m[4] * _m[2] * _m[11] +
+            _m[4] * _m[3] * _m[10] + _m[8] * _m[2] * _m[7] - _m[8] * _m[3] * _m[6],
+        _m[4] * _m[9] * _m[15] - _m[4] * _m[11] * _m[13] - _m[8] * _m[5] * _m[15] +
+            _m[8] * _m[7] * _m[13] + _m[12] * _m[5] * _m[11] - _m[12] * _m[7] * _m[9],
+        -_m[0] * _m[9] * _m[15] + _m[0] * _m[11] * _m[13] + _m[8] * _m[1] * _m[15] -
+            _m[8] * _m[3] * _m[13] - _m[12] * _m[1] * _m[11] + _m[12] * _m[3] * _m[9],
+        _m[0] * _m[5] * _m[15] - _m[0] * _m[7] * _m[13] - _m[4] * _m[1] * _m[15] +
+            _m[4] * _m[3] * _m[13] + _m[12] * _m[1] * _m[7] - _m[12] * _m[3] * _m[5],
+        -_m[0] * _m[5] * _m[11] + _m[0] * _m[7] * _m[9] + _m[4] * _m[1] * _m[11] -
+            _m[4] * _m[3] * _m[9] - _m[8] * _m[1] * _m[7] + _m[8] * _m[3] * _m[5],
+        -_m[4] * _m[9] * _m[14] + _m[4] * _m[10] * _m[13] + _m[8] * _m[5] * _m[14] -
+            _m[8] * _m[6] * _m[13] - _m[12] * _m[5] * _m[10] + _m[12] * _m[6] * _m[9],
+        _m[0] * _m[9] * _m[14] - _m[0] * _m[10] * _m[13] - _m[8] * _m[1] * _m[14] +
+            _m[8] * _m[2] * _m[13] + _m[12] * _m[1] * _m[10] - _m[12] * _m[2] * _m[9],
+        -_m[0] * _m[5] * _m[14] + _m[0] * _m[6] * _m[13] + _m[4] * _m[1] * _m[14] -
+            _m[4] * _m[2] * _m[13] - _m[12] * _m[1] * _m[6] + _m[12] * _m[2] * _m[5],
+        _m[0] * _m[5] * _m[10] - _m[0] * _m[6] * _m[9] - _m[4] * _m[1] * _m[10] +
+            _m[4] * _m[2] * _m[9] + _m[8] * _m[1] * _m[6] - _m[8] * _m[2] * _m[5]
+    };
+
+    float const determinant = _m[0] * inverse[0] + _m[1] * inverse[4] + _m[2] * inverse[8] + _m[3] * inverse[12];
+    if (determinant == 0.f)
+        return Mat4_t{ 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+    for (float &value : inverse)
+        value /= determinant;
+    return inverse;
+}
+
+static GLfloat const kClearColor[]{ 0.5f, 0.5f, 0.5f, 1.f };
+static GLfloat const kBufferClearColor[]{ 0.f, 0.f, 0.f, 0.f };
+// Outgoing kernel of a crossfade, blended with a constant alpha.
+static char const kCrossfadeKernel[] =
+    "void imageMain(inout vec4 frag_color, vec2 frag_coord) {"
+    " frag_color = vec4(texelFetch(iChannel0, ivec2(frag_coord), 0).rgb, 1.0); }\n";
+// Output image of a compute kernel, drawn as a fragment kernel would have.
+static char const kComputePresentKernel[] =
+    "void imageMain(inout vec4 frag_color, vec2 frag_coord) {"
+    " frag_color = texelFetch(iChannel0, ivec2(frag_coord), 0); }\n";
+// Appended to profiling builds of the image pass, the entry points store the
+// cost of their pixel once imageMain returns.
+static char const kCostProfiling[] =
+    "\n#define SR_COST_PROFILING 1\n"
+    "layout(r32ui, binding = " SR_STRINGIFY(SR_COST_IMAGE_UNIT) ") writeonly uniform uimage2D sr_cost_image;\n"
+    "layout(std430, binding = " SR_STRINGIFY(SR_COST_BINDING) ") buffer SRCost {"
+    " uint sr_cost_total; uint sr_cost_max; uint sr_cost_tiles[]; };\n"
+    "void sr_StoreCost(ivec2 texel) {\n"
+    "    imageStore(sr_cost_image, texel, uvec4(sr_cost));\n"
+    "    atomicAdd(sr_cost_total, sr_cost);\n"
+    "    atomicMax(sr_cost_max, sr_cost);\n"
+    "    int tile_columns = (int(" SR_SL_RESOLUTION_UNIFORM ".x) + " SR_STRINGIFY(SR_COST_TILE_SIZE) " - 1) / "
+         SR_STRINGIFY(SR_COST_TILE_SIZE) ";\n"
+    "    ivec2 tile = texel / " SR_STRINGIFY(SR_COST_TILE_SIZE) ";\n"
+    "    atomicAdd(sr_cost_tiles[tile.y * tile_columns + tile.x], sr_cost);\n"
+    "}\n";
+// Pixel costs as a blue to red ramp, relative to the costliest pixel.
+static char const kCostHeatmapKernel[] =
+    "uniform usampler2D sr_cost_texture;\n"
+    "layout(std430, binding = " SR_STRINGIFY(SR_COST_BINDING) ") readonly buffer SRCost {"
+    " uint sr_cost_total; uint sr_cost_max; };\n"
+    "void imageMain(inout vec4 frag_color, vec2 frag_coord) {"
+    " float cost = float(texelFetch(sr_cost_texture, ivec2(frag_coord), 0).r);"
+    " float t = (sr_cost_max > 0u) ? cost / float(sr_cost_max) : 0.0;"
+    " frag_color = vec4(clamp(vec3(1.5) - abs(4.0 * vec3(t) - vec3(3.0, 2.0, 1.0)), 0.0, 1.0), 1.0); }\n";
+// Appended to temporal builds of the image pass, the entry points store the
+// hit given to srSetHit once imageMain returns. srRayStart follows the ray
+// up to where the previous frame saw it land, then backs off from the
+// nearest surface the previous frame hit in the 3x3 pixels around it.
+static char const kTemporalHits[] =
+    "\n#define SR_TEMPORAL_HITS 1\n"
+    "layout(rgba32f, binding = " SR_STRINGIFY(SR_HITS_IMAGE_UNIT) ") writeonly uniform image2D sr_hit_image;\n"
+    "ivec2 sr_texel = ivec2(0);\n"
+    "vec4 sr_hit = vec4(0.0);\n"
+    "void srSetHit(vec3 ray_origin, vec3 ray_direction, float hit_distance) {\n"
+    "    sr_hit = vec4(ray_origin + ray_direction * hit_distance, hit_distance);\n"
+    "}\n"
+    "float srRayStart(vec3 ray_origin, vec3 ray_direction) {\n"
+    "    ivec2 size = textureSize(" SR_SL_PREV_HITS_UNIFORM ", 0);\n"
+    "    vec4 guess = texelFetch(" SR_SL_PREV_HITS_UNIFORM ", clamp(sr_texel, ivec2(0), size - 1), 0);\n"
+    "    if (guess.w <= 0.0)\n"
+    "        return 0.0;\n"
+    "    vec3 landing = ray_origin + ray_direction * dot(guess.xyz - ray_origin, ray_direction);\n"
+    "    vec4 clip = " SR_SL_PREV_PROJMAT_UNIFORM " * vec4(landing, 1.0);\n"
+    "    if (clip.w <= 0.0)\n"
+    "        return 0.0;\n"
+    "    ivec2 center = ivec2(floor((clip.xy / clip.w * 0.5 + 0.5) * vec2(size)));\n"
+    "    float start = dot(guess.xyz - ray_origin, ray_direction);\n"
+    "    for (int y = -1; y <= 1; ++y)\n"
+    "    for (int x = -1; x <= 1; ++x) {\n"
+    "        ivec2 texel = center + ivec2(x, y);\n"
+    "        if (any(lessThan(texel, ivec2(0))) || any(greaterThanEqual(texel, size)))\n"
+    "            return 0.0;\n"
+    "        vec4 hit = texelFetch(" SR_SL_PREV_HITS_UNIFORM ", texel, 0);\n"
+    "        if (hit.w <= 0.0)\n"
+    "            return 0.0;\n"
+    "        start = min(start, dot(hit.xyz - ray_origin, ray_direction));\n"
+    "    }\n"
+    "    return max(start * 0.95, 0.0);\n"
+    "}\n";
+using KernelSources_t = std::array<std::string, static_cast<std::size_t>(ShaderStage::kCount)>;
 
 // =============================================================================
 
 struct RenderContext::Impl_
 {
+    static oglbase::ShaderSources_t
+    AssembleKernel(ShaderStage _stage, oglbase::ShaderSources_t const &_kernel_sources);
+    // Lines AssembleKernel puts ahead of the kernel source.
+    static constexpr int kKernelPrefixLines = 10;
+    static ErrorLogContainer ParseErrorLog(std::string _error_msg);
+    static std::string JoinSources(oglbase::ShaderSources_t const &_sources);
     static std::pair<oglbase::ShaderPtr, ErrorLogContainer>
     CompileKernel(ShaderStage _stage, oglbase::ShaderSources_t const &_kernel_sources);
 
+    // Fragment kernels may declare buffer passes, each one starting at a
+    // "#pragma sr_pass bufferN" line, the image pass at "#pragma sr_pass image"
+    // and the depth prepass at "#pragma sr_pass prepass".
+    // Lines ahead of the first marker are shared by every pass, a kernel
+    // without markers is a single image pass. Lines of the other passes are
+    // blanked rather than dropped so that compiler messages keep matching the
+    // kernel file.
+    static constexpr int kImagePass = -1;
+    static constexpr int kSharedSection = -2;
+    static constexpr int kUnknownSection = -3;
+    static bool ParsePassMarker(std::string const &_line, int *o_pass);
+    static std::string PassSource(std::string const &_kernel, int _pass);
+    static std::set<int> DeclaredBufferPasses(std::string const &_kernel);
+    static std::string StageSource(ShaderStage _stage, std::string const &_kernel);
+    // Stage the kernel of _stage is compiled as, and its source for that
+    // stage, in the current execution mode.
+    ShaderStage ExecutionStage(ShaderStage _stage) const;
+    std::string ExecutionSource(ShaderStage _stage, std::string const &_kernel) const;
+    // Builds in flight were compiled for the previous execution mode, they
+    // are dropped and the watched kernel is built again.
+    void OnExecutionModeChanged();
+
+    // Kernels picked up by a single KernelsUpdate call, compiled and linked
+    // without blocking. The live program is only replaced once the whole
+    // build is complete, from PollKernelsBuild at the start of a frame.
+    struct PendingKernel
+    {
+        ShaderStage stage;
+        std::string path;
+        std::string source;
+        oglbase::ShaderPtr shader;
+        // Line map of the expanded source, source itself is moved out.
+        PreprocessedKernel preprocessed;
+        // StageKey of shader.
+        utility::Hash_t shader_key = 0u;
+    };
+
+    // Buffer pass of the fragment kernel, unchanged passes keep their live
+    // program and feedback content.
+    struct PendingPass
+    {
+        int index;
+        std::string source;
+        oglbase::ShaderPtr shader;
+        oglbase::ProgramPtr program;
+        utility::Hash_t program_key;
+        bool unchanged;
+        bool from_binary_cache;
+    };
+
+    struct KernelsBuild
+    {
+        std::vector<PendingKernel> kernels;
+        oglbase::ProgramPtr program;
+        utility::Hash_t program_key;
+        bool from_binary_cache;
+        // Set while another context builds the same program, compilation
+        // starts only if it gives up on it.
+        bool shared_wait;
+        oglbase::ProgramBuildClaim claim;
+        // Playlist builds stay quiet, their kernel isn't on screen.
+        bool report_errors;
+
+        bool update_passes;
+        std::vector<PendingPass> passes;
+        bool compiled;
+        bool linked;
+    };
+
+    // Every other built-in lives in the SRFrame block.
+    struct BuiltinBindings
+    {
+        GLint compute_rect;
+    };
+
+    struct UniformBinding
+    {
+        GLint location;
+        bool dirty;
+    };
+
+    // Uniform locations are resolved once per linked program, values are only
+    // uploaded when they differ from what the program already holds.
+    struct KernelProgram
+    {
+        oglbase::ProgramPtr program{ 0u };
+        // Content key the program is retired under once replaced, null to
+        // delete it instead.
+        utility::Hash_t program_key = 0u;
+        oglbase::UniformTable_t uniform_table{};
+        BuiltinBindings builtin_bindings{ -1 };
+        std::vector<UniformBinding> uniform_bindings{};
+
+        // Not drawn since it was linked.
+        bool builtins_dirty = true;
+        // Linked from a kCompute image stage, dispatched rather than drawn.
+        bool compute = false;
+        // Linked from a profiling build, writes pixel costs.
+        bool cost_profiled = false;
+        // Linked from a temporal build, writes ray hits.
+        bool temporal_hits = false;
+    };
+
     Impl_(RenderContext &_context);
 
     RenderContext &context_;
 
     utility::Clock exec_time_;
 
-    static constexpr float kKernelsUpdatePeriod = 1.f;
     void KernelsUpdate();
+    std::unique_ptr<KernelsBuild> MakeKernelsBuild(std::vector<PendingKernel> &&_kernels, bool _live);
+    void BeginKernelsCompile(KernelsBuild &_build);
+    // Takes the shader back from the shader cache when it was retired.
+    void BeginKernelCompile(PendingKernel &_kernel);
+    void RetireProgram(KernelProgram &_program);
+    // Returns false once the build failed, it is ready to install once linked.
+    bool AdvanceKernelsBuild(KernelsBuild &_build, bool _wait);
+    void InstallKernelsBuild(KernelsBuild &_build);
+    void PollKernelsBuild(bool _wait = false);
     std::unordered_map<ShaderStage, utility::File> kernel_files_;
+    utility::FileWatcher kernel_watcher_;
+    std::set<ShaderStage> changed_kernels_;
+    std::unique_ptr<KernelsBuild> kernels_build_;
+
+    // Kernel playlist, fragment kernels of a directory are built ahead of
+    // time, one at a time and only while no live build is in flight. A kernel
+    // switch then installs the linked program as is. An entry whose build was
+    // installed is built again, from the program binary cache by then.
+    struct PlaylistEntry
+    {
+        std::string path;
+        std::unique_ptr<KernelsBuild> build;
+        bool failed;
+    };
+    void PollPlaylist();
+    // Linked playlist build for _kernels, if still up to date.
+    std::unique_ptr<KernelsBuild> TakePlaylistBuild(std::vector<PendingKernel> const &_kernels);
+    std::vector<PlaylistEntry> playlist_;
+
+    // Files included by each kernel file, watched along with the kernels. A
+    // change only rebuilds the stages whose kernel includes the file.
+    void OnKernelFileChanged(std::string const &_path);
+    void WatchIncludes();
+    KernelPreprocessor kernel_preprocessor_;
+    std::array<std::vector<std::string>, static_cast<std::size_t>(ShaderStage::kCount)> kernel_includes_;
+    std::set<std::string> watched_includes_;
+
+    // Kernel source of each active stage of the live program. Needed to key
+    // the program binary cache, and to rebuild stages whose shader object
+    // isn't around because the program was restored from a binary.
+    KernelSources_t kernel_sources_;
+    std::string const &KernelSource(std::vector<PendingKernel> const &_overrides,
+                                    ShaderStage _stage) const;
+    static utility::Hash_t StageKey(ShaderStage _execution_stage, std::string const &_stage_source,
+                                    utility::Hash_t _seed = utility::kHashSeed);
+    utility::Hash_t ProgramKey(std::vector<PendingKernel> const &_overrides) const;
+    static utility::Hash_t BufferPassKey(std::string const &_pass_source);
+    oglbase::ProgramBinaryCache program_binary_cache_;
 
     Resolution_t resolution_;
+    // Size the kernel actually renders at, this is what iResolution reports.
+    Resolution_t render_resolution_;
+    // resolution_ of the last RenderFrame.
+    Resolution_t presented_resolution_;
+
+    // Dynamic resolution, the kernel renders to the lower left part of an
+    // internal target which is then stretched over the whole viewport. The
+    // scale follows the smoothed GPU time of the frames (gpu_timer_), with a
+    // dead band around the target so that it doesn't oscillate. Each new
+    // timer sample counts once, and the samples of frames still in flight
+    // when the scale changes are skipped. Idle periods and time spent
+    // outside of RenderFrame don't weigh in.
+    struct ResolutionGovernor
+    {
+        bool enabled;
+        float target_frame_time;
+        float min_scale;
+        GLenum filter;
+
+        float scale;
+        float frame_time;
+        std::size_t timer_sample;
+        std::size_t settle_sample;
+        std::unique_ptr<oglbase::Framebuffer> target;
+        std::array<GLsizei, 2> target_size;
+    };
+    static constexpr float kGovernorSmoothing = 0.1f;
+    static constexpr float kGovernorDeadBand = 0.1f;
+    static constexpr float kGovernorScaleStep = 1.f / 32.f;
+    void UpdateResolutionScale();
+    GLuint BeginScaledRender(GLuint _target_framebuffer);
+    void EndScaledRender(GLuint _target_framebuffer) const;
+    ResolutionGovernor governor_;
+
+    oglbase::GPUTimer gpu_timer_;
+
+    // Gizmos live in two storage buffer ranges, iGizmos (vec3, 16 bytes
+    // stride) and iGizmoParams (vec4), streamed only when they change.
+    static constexpr std::size_t kGizmoStride = 4u * sizeof(float);
+    void UpdateGizmoBuffer();
+    oglbase::StreamBuffer gizmo_buffer_;
+    std::vector<Vec3_t> uploaded_gizmo_positions_;
+    std::vector<Vec4_t> uploaded_gizmo_params_;
+    GLsizeiptr gizmo_range_size_;
+    GLintptr gizmo_params_offset_;
+    std::uint64_t gizmo_generation_;
+
+    // Built-in uniforms of the kernels, mirrors the std140 SRFrame block.
+    struct FrameBlock
+    {
+        Mat4_t projection;
+        Mat4_t inverse_projection;
+        Mat4_t previous_projection;
+        Resolution_t resolution;
+        Jitter_t jitter;
+        float time;
+        GLint gizmo_count;
+        float prepass_tile_size;
+        float padding;
+    };
+    static_assert(sizeof(FrameBlock) == 224u, "SRFrame std140 layout");
+    // Every program reads the SRFrame block at SR_FRAME_BINDING. A frame
+    // streams its blocks to a stream buffer region of kFrameSlotCount slots,
+    // a slot is only written when a program runs with other values than the
+    // bound block: at most once per frame, twice with accumulation as buffer
+    // passes aren't jittered, never for a still frame.
+    static constexpr std::size_t kFrameSlotCount = 4u;
+    struct FrameUniforms
+    {
+        oglbase::StreamBuffer buffer;
+        char* region;
+        std::size_t slot_count;
+        GLintptr bound_offset;
+        FrameBlock bound;
+        bool rebind;
+
+        // Block members are all active, whether the live kernel reads iTime
+        // or the camera is found in its source instead.
+        bool reads_time;
+        bool reads_camera;
+    };
+    static bool ReadsIdentifier(std::string const &_source, char const *_identifier);
+    void UpdateBuiltinUsage();
+    void BeginFrameUniforms();
+    void BindFrameUniforms(float _time, Jitter_t const &_jitter);
+    FrameUniforms frame_;
 
     std::set<ShaderStage> active_stages_;
     ShaderCache shader_cache_;
-    oglbase::ProgramPtr shader_program_;
-
-    UniformContainer uniforms_;
+    KernelProgram shader_program_;
+
+    void SetProgram(KernelProgram &_target, oglbase::ProgramPtr &&_program);
+    void BindUniforms(KernelProgram &_target);
+    void UploadUniforms(KernelProgram &_target, float _time, Jitter_t const &_jitter = kNoJitter);
+    template <typename Function> void ForEachProgram(Function &&_function);
+
+    UniformStore uniforms_;
+
+    // Uniform freezing, uniforms left untouched for delay seconds are baked
+    // as constants into a fragment program built in the background. It
+    // replaces the generic program until one of the frozen values changes.
+    // Only single "uniform <type> name;" declarations of the image pass can
+    // be frozen, buffer passes keep their generic program. Every set of
+    // frozen values makes another program, they are never written to the
+    // program binary cache and only outlive their use in the shader cache.
+    using UniformValue_t = std::vector<std::uint32_t>;
+    using FrozenUniforms_t = std::vector<std::pair<std::size_t, UniformValue_t>>;
+    struct Specialization
+    {
+        bool enabled;
+        float delay;
+        std::vector<utility::Clock::StdClock_t::time_point> change_times;
+
+        // Idle uniforms the program or the build in flight was derived from.
+        FrozenUniforms_t requested;
+        FrozenUniforms_t frozen;
+        KernelProgram program;
+
+        bool building;
+        bool compiled;
+        FrozenUniforms_t pending_frozen;
+        std::vector<PendingKernel> kernels;
+        oglbase::ProgramPtr pending_program;
+        utility::Hash_t program_key;
+        bool from_memory;
+    };
+    static std::string UniformLiteral(UniformType _type, void const *_data);
+    static bool FreezeUniform(std::string &io_source, UniformStore::Uniform const &_uniform, void const *_data);
+    void UpdateSpecialization();
+    void PollSpecialization();
+    void ResetSpecialization();
+    void OnUniformChanged(std::size_t _index);
+    KernelProgram &ActiveProgram();
+    Specialization specialization_;
+
+    // Buffer passes render in index order into float targets before the
+    // image pass. targets[1] holds the latest output of a pass, bound to
+    // iChannelN: passes see the current frame of the passes before them and
+    // the previous frame of themselves and the passes after them.
+    struct BufferPass
+    {
+        std::string source;
+        ShaderCache shader_cache;
+        KernelProgram program;
+        std::array<std::unique_ptr<oglbase::Framebuffer>, 2> targets;
+        std::array<GLsizei, 2> target_size;
+    };
+    static constexpr std::size_t kBufferPassCountMax = 4u;
+    // The depth prepass goes through the same machinery as the buffer passes,
+    // right after them. It renders one pixel per prepass tile, with
+    // frag_coord at the tile center and the image pass iResolution, so that
+    // it can march a cone through the whole tile and output a distance every
+    // ray of the tile can safely start from. Its latest output is bound to
+    // iRayStart rather than to a channel.
+    static constexpr std::size_t kDepthPrepass = kBufferPassCountMax;
+    static constexpr std::size_t kPassCountMax = kBufferPassCountMax + 1u;
+    struct DepthPrepass
+    {
+        bool enabled;
+        int tile_size;
+    };
+    DepthPrepass depth_prepass_;
+    void InstallBufferPasses(std::vector<PendingPass> &_passes);
+    void RenderBufferPasses(float _time);
+    void BindChannels() const;
+    void UnbindChannels() const;
+    bool HasBufferPasses() const;
+
+    // On demand rendering, both are read from what the live programs kept
+    // after linking, a kernel that never reads iTime renders the same frame
+    // until one of its inputs changes.
+    bool UsesTime() const;
+    bool NeedsRedraw() const;
+    std::array<std::unique_ptr<BufferPass>, kPassCountMax> buffer_passes_;
+    oglbase::ShaderPtr buffer_vertex_shader_;
 
     oglbase::VAOPtr dummy_vao_;
+    void DrawKernel(KernelProgram const &_program);
+
+    // Compute execution, the fragment kernel is compiled as a kCompute stage
+    // writing to target, which is then drawn like a fragment kernel output so
+    // that every render mode presents it the same way. Workgroups cover the
+    // scissor box (or the render resolution) in row-major order, or in Morton
+    // order within blocks of kMortonBlockSize^2 workgroups. A live program
+    // keeps running as it was built until a build in the new mode replaces it.
+    static constexpr GLuint kMortonBlockSize = 8u;
+    static constexpr GLuint kDispatchWidth = 1024u;
+    struct ComputeExecution
+    {
+        bool enabled;
+        std::array<int, 2> workgroup_size;
+        ComputeTileOrder tile_order;
+
+        std::unique_ptr<oglbase::Framebuffer> target;
+        std::array<GLsizei, 2> target_size;
+        oglbase::ProgramPtr present_program;
+        // Set once the present program failed to build, it isn't retried.
+        bool present_failed;
+    };
+    void DispatchKernel(KernelProgram const &_program);
+    ComputeExecution compute_;
+
+    // Cost profiling, the image pass is built with SR_COST(n) counting into a
+    // per pixel cost image and a buffer of frame totals and per tile sums.
+    // Braced loop bodies count one per iteration. The buffer of a frame is
+    // copied aside and read back a few frames later, once the copy is done,
+    // so that statistics lag behind rather than stall the frame.
+    static constexpr std::size_t kHotTileCount = 8u;
+    struct CostProfiling
+    {
+        bool enabled;
+        float heatmap_opacity;
+
+        oglbase::TexturePtr image;
+        oglbase::BufferPtr buffer;
+        GLsizeiptr buffer_size;
+        oglbase::BufferReadback readback;
+        std::array<GLsizei, 2> size;
+        bool pending;
+        oglbase::ProgramPtr heatmap_program;
+        CostStats stats;
+    };
+    static std::string InsertLoopCosts(std::string const &_source);
+    void BeginCostFrame();
+    void RenderCostHeatmap(GLuint _kernel_framebuffer);
+    CostProfiling cost_;
+
+    // Temporal ray reuse, the image pass is built with srSetHit writing the
+    // hit of each pixel to hits[0], while hits[1] holds those of the previous
+    // frame as iPrevHits along with the projection they were seen with. The
+    // two are swapped every frame, progressive tiles don't cover a whole
+    // frame and only ever see cleared hits.
+    struct TemporalHits
+    {
+        bool enabled;
+
+        std::array<oglbase::TexturePtr, 2> hits;
+        std::array<GLsizei, 2> size;
+        Mat4_t previous_projection;
+    };
+    void BeginTemporalFrame();
+    void EndTemporalFrame();
+    TemporalHits temporal_;
+
+    // Progressive mode, the fullscreen pass is split in scissored tiles and
+    // spread over as many frames as needed to fit the frame budget. Tiles are
+    // drawn to targets[0], which is swapped with targets[1] once every tile
+    // of the pass is done. The last completed pass is what gets presented.
+    // The pass restarts whenever the kernel, its uniforms, the camera, the
+    // gizmos or the resolution change, so that its tiles all see the same
+    // inputs. Tile cost is the GPU time of the tiles of a recent frame.
+    struct ProgressiveState
+    {
+        bool enabled;
+        float frame_budget;
+        int tile_size;
+
+        std::array<std::unique_ptr<oglbase::Framebuffer>, 2> targets;
+        std::array<GLsizei, 2> target_size;
+        bool has_completed;
+        int next_tile;
+        float pass_time;
+        Mat4_t projection;
+        std::uint64_t gizmo_generation;
+        oglbase::GPUTimer tile_timer;
+    };
+    void RenderTiles(float _time);
+    void PresentTiles(GLuint _target_framebuffer) const;
+    ProgressiveState progressive_;
+
+    // Accumulation mode, the image pass renders one jittered sample per frame
+    // which is blended into a running average. The history restarts whenever
+    // the kernel, its uniforms, the camera, the gizmos or the resolution
+    // change, and iTime is held at its value when the history started.
+    // Rendering stops once max_samples have been accumulated.
+    struct AccumulationState
+    {
+        bool enabled;
+        int max_samples;
+
+        std::unique_ptr<oglbase::Framebuffer> history;
+        std::array<GLsizei, 2> target_size;
+        int sample_count;
+        float time;
+        Mat4_t projection;
+        std::uint64_t gizmo_generation;
+    };
+    static float Halton(int _index, int _base);
+    void RenderAccumulated(float _time, GLuint _target_framebuffer);
+    AccumulationState accumulation_;
+
+    // Target of RenderFrames, kept between batches of the same size. A frame
+    // is copied out kReadbackLatency frames after it was rendered so that
+    // reading it back doesn't stall the frames in between.
+    static constexpr std::size_t kReadbackLatency = 2u;
+    struct OffscreenTarget
+    {
+        std::unique_ptr<oglbase::Framebuffer> framebuffer;
+        std::array<GLsizei, 2> size;
+        std::array<oglbase::BufferPtr, kReadbackLatency> readback_buffers;
+    };
+    void ResizeOffscreenTarget(std::array<GLsizei, 2> const &_size);
+    void SetUniformValue(std::size_t _index, void const *_data);
+    OffscreenTarget offscreen_;
+
+    // Crossfade out of the previous kernel once the next one is installed.
+    // The outgoing program keeps running, with its own buffer passes when
+    // the incoming kernel replaced them, into target which is blended over
+    // the incoming kernel with a weight going from 1 to 0 over duration.
+    struct Crossfade
+    {
+        float pending_duration;
+        float duration;
+        bool started;
+        float start_time;
+        KernelProgram program;
+        bool own_passes;
+        std::array<std::unique_ptr<BufferPass>, kPassCountMax> passes;
+        std::unique_ptr<oglbase::Framebuffer> target;
+        std::array<GLsizei, 2> target_size;
+        oglbase::ProgramPtr blend_program;
+    };
+    void BeginCrossfade(bool _own_passes);
+    void RetireCrossfadePrograms();
+    void RenderCrossfade(float _time, GLuint _kernel_framebuffer);
+    void EndCrossfade();
+    Crossfade crossfade_;
 
     // GEOMETRY RENDERING EXPERIMENTS
 #ifdef SR_GEOMETRY_RENDERING
@@ -190,23 +853,57 @@ struct RenderContext::Impl_
 
 RenderContext::Impl_::Impl_(RenderContext &_context) :
     context_{ _context },
-    exec_time_{ [this](float const _dt) {
-        static auto kernels_timeout = [this, update_counter = 0.f](float _dt) mutable {
-            update_counter += _dt;
-            if (update_counter > kKernelsUpdatePeriod)
-            {
-                update_counter = 0.f;
-                this->KernelsUpdate();
-            }
-        };
-        kernels_timeout(_dt);
+    exec_time_{ [this](float const) {
+        this->kernel_watcher_.Poll();
+        if (!this->changed_kernels_.empty())
+            this->KernelsUpdate();
     }},
+    kernel_files_{},
+    kernel_watcher_{},
+    changed_kernels_{},
+    kernels_build_{},
+    playlist_{},
+    kernel_preprocessor_{},
+    kernel_includes_{},
+    watched_includes_{},
+    kernel_sources_{},
+    program_binary_cache_{ SR_PROGRAM_CACHE_DIR },
     resolution_{ 0.f, 0.f },
+    render_resolution_{ 0.f, 0.f },
+    presented_resolution_{ 0.f, 0.f },
+    governor_{ false, kDefaultFrameBudget, kDefaultMinResolutionScale, GL_LINEAR,
+               1.f, 0.f, 0u, 0u, {}, { 0, 0 } },
+    gpu_timer_{},
+    gizmo_buffer_{},
+    uploaded_gizmo_positions_{},
+    uploaded_gizmo_params_{},
+    gizmo_range_size_{ 0 },
+    gizmo_params_offset_{ 0 },
+    gizmo_generation_{ 0u },
+    frame_{ {}, nullptr, 0u, -1, FrameBlock{}, true, false, false },
     active_stages_{ ShaderStage::kVertex, ShaderStage::kFragment },
     shader_cache_{},
-    shader_program_{ 0u },
+    shader_program_{},
     uniforms_{},
-    dummy_vao_{ 0u }
+    specialization_{ false, kDefaultUniformFreezeDelay, {},
+                     {}, {}, {},
+                     false, false, {}, {}, oglbase::ProgramPtr{ 0u }, 0u, false },
+    depth_prepass_{ true, kDefaultPrepassTileSize },
+    buffer_passes_{},
+    buffer_vertex_shader_{ 0u },
+    dummy_vao_{ 0u },
+    compute_{ false, { kDefaultWorkgroupSize, kDefaultWorkgroupSize }, ComputeTileOrder::kRowMajor,
+              {}, { 0, 0 }, oglbase::ProgramPtr{ 0u }, false },
+    cost_{ false, kDefaultHeatmapOpacity,
+           oglbase::TexturePtr{ 0u }, oglbase::BufferPtr{ 0u }, 0, {}, { 0, 0 }, false, oglbase::ProgramPtr{ 0u },
+           CostStats{ 0u, 0u, 0.f, SR_COST_TILE_SIZE, {} } },
+    temporal_{ false, { oglbase::TexturePtr{ 0u }, oglbase::TexturePtr{ 0u } }, { 0, 0 }, {} },
+    progressive_{ false, kDefaultFrameBudget, kDefaultTileSize,
+                  {}, { 0, 0 }, false, 0, 0.f, {}, 0u, {} },
+    accumulation_{ false, kDefaultAccumulationSamples,
+                   {}, { 0, 0 }, 0, 0.f, {}, 0u },
+    offscreen_{ {}, { 0, 0 }, {} },
+    crossfade_{ 0.f, 0.f, false, 0.f, {}, false, {}, {}, { 0, 0 }, oglbase::ProgramPtr{ 0u } }
 
 #ifdef SR_GEOMETRY_RENDERING
     ,point_count_{ 0 },
@@ -216,19 +913,40 @@ RenderContext::Impl_::Impl_(RenderContext &_context) :
 {
     {
         glGenVertexArrays(1, dummy_vao_.get());
+        oglbase::EnableParallelShaderCompile();
     }
 
+    kernel_watcher_.onFileChanged.listeners_.emplace_back(
+        [this](std::string const& _path) {
+            this->OnKernelFileChanged(_path);
+        });
+
     {
         for (ShaderStage stage : active_stages_)
+            kernel_sources_[static_cast<std::size_t>(stage)] = JoinSources(DefaultKernel(stage));
+
+        utility::Hash_t const program_key = ProgramKey({});
+        oglbase::ProgramPtr program = program_binary_cache_.Load(program_key);
+        if (!program)
         {
-            shader_cache_[stage] = CompileKernel(stage, DefaultKernel(stage)).first;
-            assert(shader_cache_[stage]);
-        }
+            for (ShaderStage stage : active_stages_)
+            {
+                std::string const stage_source =
+                    StageSource(stage, kernel_sources_[static_cast<std::size_t>(stage)]);
+                shader_cache_.Install(stage, CompileKernel(stage, { stage_source.c_str() }).first,
+                                      StageKey(stage, stage_source));
+                assert(shader_cache_[stage]);
+            }
 
-        oglbase::ShaderBinaries_t const shader_binaries =
-            shader_cache_.select(active_stages_);
-        shader_program_ = oglbase::LinkProgram(shader_binaries);
-        assert(shader_program_);
+            oglbase::ShaderBinaries_t const shader_binaries =
+                shader_cache_.select(active_stages_);
+            program = oglbase::LinkProgram(shader_binaries, program_binary_cache_.enabled());
+            program_binary_cache_.Store(program_key, program);
+        }
+        SetProgram(shader_program_, std::move(program));
+        shader_program_.program_key = program_key;
+        assert(shader_program_.program);
+        UpdateBuiltinUsage();
     }
 
 #ifdef SR_GEOMETRY_RENDERING
@@ -250,12 +968,14 @@ RenderContext::Impl_::Impl_(RenderContext &_context) :
 
         glBindBuffer(GL_ARRAY_BUFFER, 0u);
 
-        shader_cache_[ShaderStage::kVertex] = CompileKernel(ShaderStage::kVertex, kProcessingVKernel()).first;
-        shader_cache_[ShaderStage::kGeometry] = CompileKernel(ShaderStage::kGeometry, kProcessingGKernel()).first;
+        shader_cache_.Install(ShaderStage::kVertex, CompileKernel(ShaderStage::kVertex, kProcessingVKernel()).first, 0u);
+        shader_cache_.Install(ShaderStage::kGeometry, CompileKernel(ShaderStage::kGeometry, kProcessingGKernel()).first, 0u);
+        kernel_sources_[static_cast<std::size_t>(ShaderStage::kVertex)] = JoinSources(kProcessingVKernel());
+        kernel_sources_[static_cast<std::size_t>(ShaderStage::kGeometry)] = JoinSources(kProcessingGKernel());
         active_stages_ = std::set<ShaderStage>{ ShaderStage::kVertex,
                                                 ShaderStage::kGeometry,
                                                 ShaderStage::kFragment };
-        shader_program_ = oglbase::LinkProgram(shader_cache_.select(active_stages_));
+        SetProgram(shader_program_, oglbase::LinkProgram(shader_cache_.select(active_stages_)));
     }
 #endif
 }
@@ -264,269 +984,2933 @@ RenderContext::Impl_::Impl_(RenderContext &_context) :
 void
 RenderContext::Impl_::KernelsUpdate()
 {
-    using KernelFile = std::pair<const ShaderStage, utility::File>;
-    using UpdatedShadersLUT = std::unordered_map<ShaderStage, oglbase::ShaderPtr>;
-    UpdatedShadersLUT updated_shaders;
+    std::vector<PendingKernel> kernels{};
+
+    for (ShaderStage stage : changed_kernels_)
+    {
+        auto const kernel_file_it = kernel_files_.find(stage);
+        if (kernel_file_it == kernel_files_.end())
+            continue;
 
-    bool link_required = std::any_of(std::begin(kernel_files_), std::end(kernel_files_),
-                                     [this, &updated_shaders](KernelFile &_kernel_file) {
-        bool const kernel_file_available = _kernel_file.second.Exists();
-        if (kernel_file_available && _kernel_file.second.HasChanged())
+        utility::File &kernel_file = kernel_file_it->second;
+        if (kernel_file.Exists())
         {
             std::cout << "Kernel file changed, building.." << std::endl;
-            std::pair<oglbase::ShaderPtr, ErrorLogContainer> comp_result =
-                CompileKernel(_kernel_file.first, { _kernel_file.second.ReadAll().c_str() });
-            context_.onFKernelCompileFinished(_kernel_file.second.path(), comp_result.second);
-            if (!comp_result.first)
+            PreprocessedKernel preprocessed = kernel_preprocessor_.Process(kernel_file.path(),
+                                                                           kernel_file.ReadAll());
+            kernel_includes_[static_cast<std::size_t>(stage)].assign(
+                std::next(preprocessed.files.cbegin()), preprocessed.files.cend());
+            if (!preprocessed.errors.empty())
             {
-                std::cout << "Shader compilation failed" << std::endl;
-                return false;
+                context_.onFKernelCompileFinished(kernel_file.path(), preprocessed.errors);
+                continue;
             }
 
-            updated_shaders[_kernel_file.first] = std::move(comp_result.first);
-            return true;
+            std::string source = std::move(preprocessed.source);
+            kernels.push_back(PendingKernel{
+                stage,
+                kernel_file.path(),
+                std::move(source),
+                oglbase::ShaderPtr{ 0u },
+                std::move(preprocessed)
+            });
         }
-        else if (!kernel_file_available)
+        else
         {
             std::cout << "Kernel file is either nonexistent, or not a regular file" << std::endl;
         }
-        return false;
-    });
-
-    if (link_required)
-    {
-        oglbase::ProgramPtr linked_program = oglbase::LinkProgram(
-            [](std::set<ShaderStage> const& _active_stages,
-               UpdatedShadersLUT const& _updated_shaders,
-               ShaderCache const& _shader_cache)
-            {
-                oglbase::ShaderBinaries_t result{};
-                for (ShaderStage stage : _active_stages)
-                {
-                    auto const updated_shader_it = _updated_shaders.find(stage);
-                    if (updated_shader_it != std::end(_updated_shaders))
-                    {
-                        result.emplace_back(updated_shader_it->second);
-                    }
-                    else
-                    {
-                        oglbase::ShaderPtr const& cached_shader = _shader_cache[stage];
-                        assert(cached_shader);
-                        result.emplace_back(cached_shader);
-                    }
-                }
-                assert(result.size() == _active_stages.size());
-                return result;
-            } (active_stages_, updated_shaders, shader_cache_)
-        );
-        if (!linked_program)
-        {
-            std::cout << "Program link failed" << std::endl;
-            return;
-        }
+    }
+    changed_kernels_.clear();
+    WatchIncludes();
 
-        std::cout << "Linked updated program" << std::endl;
+    if (kernels.empty())
+        return;
 
-        for (auto&& updated_shader : updated_shaders)
-            shader_cache_[updated_shader.first] = std::move(updated_shader.second);
-        shader_program_ = std::move(linked_program);
+    // A newer build supersedes whatever is still in flight.
+    kernels_build_ = TakePlaylistBuild(kernels);
+    if (kernels_build_)
+    {
+        std::cout << "Program prewarmed by the playlist" << std::endl;
+        context_.onFKernelCompileFinished(kernels.front().path, ErrorLogContainer{});
+        PollKernelsBuild();
+        return;
     }
+    kernels_build_ = MakeKernelsBuild(std::move(kernels), true);
 }
 
 
-std::pair<oglbase::ShaderPtr, ErrorLogContainer>
-RenderContext::Impl_::CompileKernel(ShaderStage _stage, oglbase::ShaderSources_t const &_kernel_sources)
+std::unique_ptr<RenderContext::Impl_::KernelsBuild>
+RenderContext::Impl_::MakeKernelsBuild(std::vector<PendingKernel> &&_kernels, bool _live)
 {
-    static oglbase::ShaderSources_t const kKernelPrefix{
-        SR_GLSL_VERSION,
-        "uniform float " SR_SL_TIME_UNIFORM ";\n",
-        "uniform vec2 " SR_SL_RESOLUTION_UNIFORM ";\n",
-
-        "uniform mat4 " SR_SL_PROJMAT_UNIFORM ";\n",
-
-        "uniform vec3 " SR_SL_GIZMOS_UNIFORM "[" SR_SL_GIZMOS_MAX "];\n",
-        "uniform int " SR_SL_GIZMO_COUNT_UNIFORM ";\n",
-    };
-    oglbase::ShaderSources_t const &kernel_suffix = KernelSuffix(_stage);
-
-    oglbase::ShaderSources_t shader_sources{};
-    shader_sources.reserve(kKernelPrefix.size() + _kernel_sources.size() + kernel_suffix.size());
-    std::copy(kKernelPrefix.cbegin(), kKernelPrefix.cend(), std::back_inserter(shader_sources));
-    std::copy(_kernel_sources.cbegin(), _kernel_sources.cend(), std::back_inserter(shader_sources));
-    std::copy(kernel_suffix.cbegin(), kernel_suffix.cend(), std::back_inserter(shader_sources));
-
+    std::unique_ptr<KernelsBuild> build = std::make_unique<KernelsBuild>();
+    build->kernels = std::move(_kernels);
+    build->program_key = ProgramKey(build->kernels);
+    // Restored programs, from memory or from the binary cache, skip the
+    // compilation.
+    build->program = shader_cache_.TakeProgram(build->program_key);
+    bool const from_memory = build->program;
+    if (!from_memory)
+        build->program = program_binary_cache_.Load(build->program_key);
+    build->from_binary_cache = build->program;
+    build->shared_wait = false;
+    build->report_errors = _live;
+    build->compiled = false;
+    build->linked = false;
+    if (from_memory)
+    {
+        std::cout << "Program restored from memory" << std::endl;
+    }
+    else if (build->from_binary_cache)
+    {
+        std::cout << "Program restored from binary cache" << std::endl;
+    }
+    else
+    {
+        build->claim = program_binary_cache_.Claim(build->program_key);
+        build->shared_wait = !build->claim;
+        if (build->shared_wait)
+            std::cout << "Program is being built by another context, waiting.." << std::endl;
+        else
+            BeginKernelsCompile(*build);
+    }
 
-    std::string error_msg;
-    ErrorLogContainer errorlog;
-    oglbase::ShaderPtr shader = oglbase::CompileShader(ShaderStageToGLenum(_stage), shader_sources, &error_msg);
-    if (!shader)
+    // Buffer passes are declared by the fragment kernel and always use the
+    // fullscreen vertex stage, a vertex kernel update leaves them alone.
+    auto const fragment_it = std::find_if(build->kernels.cbegin(), build->kernels.cend(),
+                                          [](PendingKernel const& _kernel) {
+                                              return _kernel.stage == ShaderStage::kFragment;
+                                          });
+    build->update_passes = (fragment_it != build->kernels.cend());
+    if (build->update_passes)
     {
-        while (!error_msg.empty())
+        for (int index : DeclaredBufferPasses(fragment_it->source))
         {
-            std::string head = [](std::string &_in){
-                std::size_t index = _in.find('\n');
-                std::string head = _in.substr(0, index);
-                _in = _in.substr(index+1);
-                return head;
-            }(error_msg);
-
-            int line_index = 0;
-            std::string message = head;
+            PendingPass pass{ index, PassSource(fragment_it->source, index),
+                              oglbase::ShaderPtr{ 0u }, oglbase::ProgramPtr{ 0u },
+                              0u, false, false };
+
+            // Prewarmed passes are installed against whatever passes are live
+            // by then, and a crossfade keeps the outgoing ones.
+            BufferPass const *live_pass = buffer_passes_[static_cast<std::size_t>(index)].get();
+            pass.unchanged = _live && crossfade_.pending_duration <= 0.f &&
+                live_pass && live_pass->source == pass.source;
+            if (!pass.unchanged)
             {
-                std::size_t const linenum_begin = head.find(':') + 1;
-                std::size_t const linenum_end = head.find(':', linenum_begin) + 1;
-                std::size_t const paren_begin = head.find('(', linenum_begin);
-                std::size_t const message_begin = head.find(':', linenum_end);
-
-                if (linenum_begin != ~0ull &&
-                    linenum_end != ~0ull &&
-                    paren_begin != ~0ull &&
-                    message_begin != ~0ull)
+                pass.program_key = BufferPassKey(pass.source);
+                pass.program = shader_cache_.TakeProgram(pass.program_key);
+                if (!pass.program)
+                    pass.program = program_binary_cache_.Load(pass.program_key);
+                pass.from_binary_cache = pass.program;
+                if (!pass.from_binary_cache)
                 {
-                    message = head.substr(message_begin+2);
-                    line_index = std::stoi(head.substr(linenum_begin, paren_begin-linenum_begin)) - 3;
+                    if (!buffer_vertex_shader_)
+                        buffer_vertex_shader_ = CompileKernel(ShaderStage::kVertex, DefaultKernel(ShaderStage::kVertex)).first;
+                    pass.shader = oglbase::BeginCompileShader(GL_FRAGMENT_SHADER,
+                                                              AssembleKernel(ShaderStage::kFragment, { pass.source.c_str() }));
                 }
             }
+            build->passes.push_back(std::move(pass));
+        }
+    }
+    return build;
+}
 
-            errorlog.emplace_back(std::make_pair(line_index, message));
+
+void
+RenderContext::Impl_::BeginKernelsCompile(KernelsBuild &_build)
+{
+    for (ShaderStage stage : active_stages_)
+    {
+        bool const pending = std::any_of(_build.kernels.cbegin(), _build.kernels.cend(),
+                                         [stage](PendingKernel const& _kernel) {
+                                             return _kernel.stage == stage;
+                                         });
+        if (!pending && !shader_cache_[stage])
+        {
+            _build.kernels.push_back(PendingKernel{
+                stage,
+                std::string{},
+                kernel_sources_[static_cast<std::size_t>(stage)],
+                oglbase::ShaderPtr{ 0u },
+                PreprocessedKernel{}
+            });
         }
     }
-    return std::make_pair(std::move(shader), std::move(errorlog));
+
+    for (PendingKernel &kernel : _build.kernels)
+        BeginKernelCompile(kernel);
 }
 
 
-// =============================================================================
+void
+RenderContext::Impl_::BeginKernelCompile(PendingKernel &_kernel)
+{
+    ShaderStage const stage = ExecutionStage(_kernel.stage);
+    std::string const stage_source = ExecutionSource(_kernel.stage, _kernel.source);
+    _kernel.shader_key = StageKey(stage, stage_source);
+    _kernel.shader = shader_cache_.TakeShader(_kernel.shader_key);
+    if (!_kernel.shader)
+        _kernel.shader = oglbase::BeginCompileShader(ShaderStageToGLenum(stage),
+                                                     AssembleKernel(stage, { stage_source.c_str() }));
+}
 
-RenderContext::RenderContext() :
-    impl_(new RenderContext::Impl_(*this))
-{}
 
-RenderContext::~RenderContext()
-{ delete impl_; }
+void
+RenderContext::Impl_::RetireProgram(KernelProgram &_program)
+{
+    if (_program.program && _program.program_key)
+        shader_cache_.RetireProgram(_program.program_key, std::move(_program.program));
+}
 
-bool
-RenderContext::RenderFrame()
+
+void
+RenderContext::Impl_::PollKernelsBuild(bool _wait)
 {
-    float const elapsed_time = impl_->exec_time_.read();
-    impl_->exec_time_.step();
+    if (!kernels_build_)
+        return;
 
-    bool start_over = true;
+    if (!AdvanceKernelsBuild(*kernels_build_, _wait))
+    {
+        kernels_build_.reset();
+        return;
+    }
+    if (!kernels_build_->linked)
+        return;
 
-    assert(!oglbase::ClearError());
+    InstallKernelsBuild(*kernels_build_);
+    kernels_build_.reset();
+}
 
-    glDisable(GL_MULTISAMPLE);
-    glDisable(GL_BLEND);
-    glDisable(GL_SCISSOR_TEST);
-    glDisable(GL_STENCIL_TEST);
-    glDisable(GL_DEPTH_TEST);
-    glFrontFace(GL_CCW);
-    glEnable(GL_CULL_FACE);
 
-    static GLfloat const clear_color[]{ 0.5f, 0.5f, 0.5f, 1.f };
-    glClearBufferfv(GL_COLOR, 0, clear_color);
+bool
+RenderContext::Impl_::AdvanceKernelsBuild(KernelsBuild &_build, bool _wait)
+{
+    if (_build.linked)
+        return true;
+
+    if (_build.shared_wait)
+    {
+        // The other context may be driven from this very thread, a blocking
+        // wait takes the build over rather than waiting on it.
+        if (!_wait && program_binary_cache_.Claimed(_build.program_key))
+            return true;
 
-    glUseProgram(impl_->shader_program_);
+        _build.shared_wait = false;
+        _build.program = program_binary_cache_.Load(_build.program_key);
+        _build.from_binary_cache = _build.program;
+        if (_build.from_binary_cache)
+        {
+            std::cout << "Program shared by another context" << std::endl;
+        }
+        else
+        {
+            _build.claim = program_binary_cache_.Claim(_build.program_key);
+            BeginKernelsCompile(_build);
+        }
+    }
 
+    if (!_build.compiled)
     {
-        int const time_loc = glGetUniformLocation(impl_->shader_program_, SR_SL_TIME_UNIFORM);
-        if (time_loc >= 0)
-            glUniform1f(time_loc, elapsed_time);
+        bool const compile_done = _wait ||
+            (std::all_of(_build.kernels.cbegin(), _build.kernels.cend(),
+                         [](PendingKernel const& _kernel) {
+                             return !_kernel.shader || oglbase::IsShaderReady(_kernel.shader);
+                         }) &&
+             std::all_of(_build.passes.cbegin(), _build.passes.cend(),
+                         [](PendingPass const& _pass) {
+                             return !_pass.shader || oglbase::IsShaderReady(_pass.shader);
+                         }));
+        if (!compile_done)
+            return true;
+
+        // Buffer passes live in the fragment kernel file, their errors are
+        // reported along with the ones of the image pass.
+        bool passes_compiled = true;
+        ErrorLogContainer passes_errorlog;
+        for (PendingPass &pass : _build.passes)
+        {
+            std::string error_msg;
+            if (pass.shader && !oglbase::EndCompileShader(pass.shader, &error_msg))
+            {
+                std::cout << "Buffer pass " << pass.index << " compilation failed" << std::endl;
+                ErrorLogContainer const errorlog = ParseErrorLog(std::move(error_msg));
+                passes_errorlog.insert(passes_errorlog.end(), errorlog.cbegin(), errorlog.cend());
+                passes_compiled = false;
+            }
+        }
 
-        int const resolution_loc = glGetUniformLocation(impl_->shader_program_, SR_SL_RESOLUTION_UNIFORM);
-        if (resolution_loc >= 0)
-            glUniform2fv(resolution_loc, 1, &(impl_->resolution_[0]));
+        for (PendingKernel &kernel : _build.kernels)
+        {
+            std::string error_msg;
+            ErrorLogContainer errorlog;
+            if (!_build.from_binary_cache && !oglbase::EndCompileShader(kernel.shader, &error_msg))
+            {
+                std::cout << "Shader compilation failed" << std::endl;
+                errorlog = ParseErrorLog(std::move(error_msg));
+            }
+            if (kernel.stage == ShaderStage::kFragment)
+                errorlog.insert(errorlog.end(), passes_errorlog.cbegin(), passes_errorlog.cend());
+            kernel.preprocessed.RemapErrorLog(errorlog);
+            if (kernel.stage == ShaderStage::kFragment && !passes_errorlog.empty())
+            {
+                std::stable_sort(errorlog.begin(), errorlog.end(),
+                                 [](std::pair<int, std::string> const& _lhs,
+                                    std::pair<int, std::string> const& _rhs) {
+                                     return _lhs.first < _rhs.first;
+                                 });
+            }
+            if (_build.report_errors && !kernel.path.empty())
+                context_.onFKernelCompileFinished(kernel.path, errorlog);
+        }
 
-        int const projmat_loc = glGetUniformLocation(impl_->shader_program_, SR_SL_PROJMAT_UNIFORM);
-        if (projmat_loc >= 0)
-            glUniformMatrix4fv(projmat_loc, 1, GL_FALSE, &projection_matrix[0]);
+        if (!passes_compiled)
+        {
+            return false;
+        }
 
-        int const gizmos_loc = glGetUniformLocation(impl_->shader_program_, SR_SL_GIZMOS_UNIFORM);
-        if (gizmos_loc >= 0)
+        if (!_build.from_binary_cache)
         {
-            int const gizmocount_loc = glGetUniformLocation(impl_->shader_program_, SR_SL_GIZMO_COUNT_UNIFORM);
-            if (gizmocount_loc >= 0)
-                glUniform1i(gizmocount_loc, (GLint)gizmo_count);
+            std::size_t const kernel_count = _build.kernels.size();
+            _build.kernels.erase(std::remove_if(_build.kernels.begin(), _build.kernels.end(),
+                                               [](PendingKernel const& _kernel) {
+                                                   return !_kernel.shader;
+                                               }),
+                                _build.kernels.end());
+            bool const file_kernel_built = std::any_of(_build.kernels.cbegin(), _build.kernels.cend(),
+                                                       [](PendingKernel const& _kernel) {
+                                                           return !_kernel.path.empty();
+                                                       });
+            if (!file_kernel_built)
+            {
+                return false;
+            }
+            if (_build.kernels.size() != kernel_count)
+                _build.program_key = ProgramKey(_build.kernels);
+
+            oglbase::ShaderBinaries_t binaries{};
+            for (ShaderStage stage : active_stages_)
+            {
+                auto const updated_kernel_it = std::find_if(_build.kernels.cbegin(), _build.kernels.cend(),
+                                                            [stage](PendingKernel const& _kernel) {
+                                                                return _kernel.stage == stage;
+                                                            });
+                if (updated_kernel_it != _build.kernels.cend())
+                {
+                    binaries.emplace_back(updated_kernel_it->shader);
+                }
+                else
+                {
+                    oglbase::ShaderPtr const& cached_shader = shader_cache_[stage];
+                    if (!cached_shader)
+                    {
+                        return false;
+                    }
+                    binaries.emplace_back(cached_shader);
+                }
+            }
+            assert(binaries.size() == active_stages_.size());
+
+            _build.program = oglbase::BeginLinkProgram(binaries, program_binary_cache_.enabled());
+        }
 
-            for (unsigned i = 0; i < kGizmoCountMax; ++i)
-                glUniform3fv(gizmos_loc + i, 1, &gizmo_positions[i][0]);
+        for (PendingPass &pass : _build.passes)
+        {
+            if (pass.shader)
+            {
+                pass.program = oglbase::BeginLinkProgram({ buffer_vertex_shader_, pass.shader },
+                                                         program_binary_cache_.enabled());
+            }
         }
+        _build.compiled = true;
     }
 
-    for (std::pair<std::string, float> const& uniform : impl_->uniforms_)
+    bool const link_done = _wait ||
+        (oglbase::IsProgramReady(_build.program) &&
+         std::all_of(_build.passes.cbegin(), _build.passes.cend(),
+                     [](PendingPass const& _pass) {
+                         return _pass.unchanged || oglbase::IsProgramReady(_pass.program);
+                     }));
+    if (!link_done)
+        return true;
+
+    if (!oglbase::EndLinkProgram(_build.program))
     {
-        int const location = glGetUniformLocation(impl_->shader_program_, uniform.first.c_str());
-        if (location >= 0)
-            glUniform1f(location, uniform.second);
+        std::cout << "Program link failed" << std::endl;
+        return false;
     }
 
-#ifdef SR_GEOMETRY_RENDERING
-    glBindVertexArray(impl_->vao_);
-    glDrawArrays(GL_POINTS, 0, impl_->point_count_);
-    glBindVertexArray(0u);
-#else
-    glBindVertexArray(impl_->dummy_vao_);
-    glDrawArrays(GL_TRIANGLES, 0, 3);
-    glBindVertexArray(0u);
-#endif
+    for (PendingPass &pass : _build.passes)
+    {
+        if (!pass.unchanged && !oglbase::EndLinkProgram(pass.program))
+        {
+            std::cout << "Buffer pass " << pass.index << " link failed" << std::endl;
+            return false;
+        }
+    }
 
-    glUseProgram(0u);
+    std::cout << "Linked updated program" << std::endl;
 
-#ifdef SR_SINGLE_BUFFERING
-    glFlush();
-#endif
+    if (!_build.from_binary_cache)
+        program_binary_cache_.Store(_build.program_key, _build.program);
+    for (PendingPass const &pass : _build.passes)
+    {
+        if (!pass.unchanged && !pass.from_binary_cache)
+            program_binary_cache_.Store(pass.program_key, pass.program);
+    }
 
-    start_over = start_over && (glGetError() == GL_NO_ERROR);
-    return start_over;
+    _build.claim = oglbase::ProgramBuildClaim{};
+    _build.linked = true;
+    return true;
 }
 
+
 void
-RenderContext::WatchKernelFile(ShaderStage _stage, char const *_path)
+RenderContext::Impl_::InstallKernelsBuild(KernelsBuild &_build)
 {
-    if (impl_->active_stages_.count(_stage) != 0)
+    for (PendingKernel &kernel : _build.kernels)
     {
-        impl_->kernel_files_[_stage] = utility::File{ _path };
-        impl_->KernelsUpdate();
+        shader_cache_.Install(kernel.stage, std::move(kernel.shader), kernel.shader_key);
+        kernel_sources_[static_cast<std::size_t>(kernel.stage)] = std::move(kernel.source);
     }
+
+    bool const passes_reused = std::any_of(_build.passes.cbegin(), _build.passes.cend(),
+                                           [](PendingPass const& _pass) {
+                                               return _pass.unchanged;
+                                           });
+    BeginCrossfade(_build.update_passes && !passes_reused);
+
+    RetireProgram(shader_program_);
+    SetProgram(shader_program_, std::move(_build.program));
+    shader_program_.program_key = _build.program_key;
+    shader_program_.compute = compute_.enabled;
+    shader_program_.cost_profiled = cost_.enabled;
+    shader_program_.temporal_hits = temporal_.enabled;
+    ResetSpecialization();
+    if (_build.update_passes)
+        InstallBufferPasses(_build.passes);
+    progressive_.next_tile = 0;
+    accumulation_.sample_count = 0;
+    UpdateBuiltinUsage();
 }
 
-void
-RenderContext::SetResolution(int _width, int _height)
+
+std::unique_ptr<RenderContext::Impl_::KernelsBuild>
+RenderContext::Impl_::TakePlaylistBuild(std::vector<PendingKernel> const &_kernels)
 {
-    impl_->resolution_ = { boost::numeric_cast<float>(_width),
-                           boost::numeric_cast<float>(_height) };
-    glViewport(0, 0, _width, _height);
+    if (_kernels.size() != 1u || _kernels.front().stage != ShaderStage::kFragment)
+        return nullptr;
+
+    auto const entry_it = std::find_if(playlist_.begin(), playlist_.end(),
+                                       [&_kernels](PlaylistEntry const& _entry) {
+                                           return _entry.path == _kernels.front().path;
+                                       });
+    if (entry_it == playlist_.end() || !entry_it->build)
+        return nullptr;
+
+    // An entry still in flight is dropped so that the live build can claim
+    // the program, a stale one (kernel edited since, other vertex kernel) is
+    // built again later on.
+    std::unique_ptr<KernelsBuild> build = std::move(entry_it->build);
+    if (!build->linked || build->program_key != ProgramKey(_kernels))
+        return nullptr;
+    return build;
 }
 
 
 void
-RenderContext::SetUniforms(UniformContainer const&_uniforms)
+RenderContext::Impl_::PollPlaylist()
 {
-    impl_->uniforms_ = _uniforms;
-}
+    if (kernels_build_ || playlist_.empty())
+        return;
+
+    auto const building_it = std::find_if(playlist_.begin(), playlist_.end(),
+                                          [](PlaylistEntry const& _entry) {
+                                              return _entry.build && !_entry.build->linked;
+                                          });
+    if (building_it != playlist_.end())
+    {
+        if (!AdvanceKernelsBuild(*building_it->build, false))
+        {
+            std::cout << "Playlist kernel build failed " << building_it->path << std::endl;
+            building_it->build.reset();
+            building_it->failed = true;
+        }
+        return;
+    }
 
-UniformContainer const&
-RenderContext::GetUniforms() const
-{
-    return impl_->uniforms_;
+    auto const next_it = std::find_if(playlist_.begin(), playlist_.end(),
+                                      [](PlaylistEntry const& _entry) {
+                                          return !_entry.build && !_entry.failed;
+                                      });
+    if (next_it == playlist_.end())
+        return;
+
+    utility::File kernel_file{ next_it->path };
+    PreprocessedKernel preprocessed{};
+    if (kernel_file.Exists())
+        preprocessed = kernel_preprocessor_.Process(kernel_file.path(), kernel_file.ReadAll());
+    if (!kernel_file.Exists() || !preprocessed.errors.empty())
+    {
+        next_it->failed = true;
+        return;
+    }
+
+    std::string source = std::move(preprocessed.source);
+    std::vector<PendingKernel> kernels{};
+    kernels.push_back(PendingKernel{
+        ShaderStage::kFragment,
+        kernel_file.path(),
+        std::move(source),
+        oglbase::ShaderPtr{ 0u },
+        std::move(preprocessed)
+    });
+    next_it->build = MakeKernelsBuild(std::move(kernels), false);
 }
 
-std::string const &
-RenderContext::GetKernelPath(ShaderStage _stage) const
+
+void
+RenderContext::Impl_::OnKernelFileChanged(std::string const &_path)
 {
-    auto const kernel_file_it = impl_->kernel_files_.find(_stage);
-    if (kernel_file_it != std::end(impl_->kernel_files_))
-        return kernel_file_it->second.path();
-    else
+    for (auto &&kernel_file : kernel_files_)
     {
-        static std::string const empty{ "" };
-        return empty;
+        if (kernel_file.second.path() == _path)
+            changed_kernels_.insert(kernel_file.first);
     }
-}
 
+    if (watched_includes_.count(_path) == 0)
+        return;
 
-} //namespace sr
+    if (!kernel_preprocessor_.Refresh(_path))
+    {
+        std::cout << "Include file unchanged " << _path << std::endl;
+        return;
+    }
 
-extern "C"
+    std::set<std::string> const dependents = kernel_preprocessor_.Dependents(_path);
+    for (auto &&kernel_file : kernel_files_)
+    {
+        if (dependents.count(kernel_file.second.path()) != 0)
+            changed_kernels_.insert(kernel_file.first);
+    }
+}
+
+
+void
+RenderContext::Impl_::WatchIncludes()
+{
+    std::set<std::string> includes{};
+    for (auto &&kernel_file : kernel_files_)
+    {
+        std::vector<std::string> const &stage_includes =
+            kernel_includes_[static_cast<std::size_t>(kernel_file.first)];
+        includes.insert(stage_includes.cbegin(), stage_includes.cend());
+    }
+    // Kernel files are watched on their own.
+    for (auto &&kernel_file : kernel_files_)
+        includes.erase(kernel_file.second.path());
+
+    for (std::string const &path : watched_includes_)
+    {
+        if (includes.count(path) == 0)
+            kernel_watcher_.Unwatch(path);
+    }
+    for (std::string const &path : includes)
+    {
+        if (watched_includes_.count(path) == 0)
+            kernel_watcher_.Watch(path);
+    }
+    watched_includes_ = std::move(includes);
+}
+
+
+std::string
+RenderContext::Impl_::UniformLiteral(UniformType _type, void const *_data)
+{
+    std::size_t const count = UniformComponentCount(_type);
+    std::ostringstream literal{};
+    literal << UniformTypeName(_type) << '(';
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (i > 0u)
+            literal << ", ";
+        if (_type == UniformType::kBool)
+        {
+            literal << ((static_cast<GLint const*>(_data)[i] != 0) ? "true" : "false");
+        }
+        else if (IsIntegerUniform(_type))
+        {
+            literal << static_cast<GLint const*>(_data)[i];
+        }
+        else
+        {
+            // Written with enough digits to read back the exact same float.
+            float const value = static_cast<float const*>(_data)[i];
+            if (!std::isfinite(value))
+                return std::string{};
+            char digits[32];
+            std::snprintf(digits, sizeof(digits), "%.9e", static_cast<double>(value));
+            literal << digits;
+        }
+    }
+    literal << ')';
+    return literal.str();
+}
+
+
+bool
+RenderContext::Impl_::FreezeUniform(std::string &io_source, UniformStore::Uniform const &_uniform, void const *_data)
+{
+    std::string const &name = _uniform.name;
+    std::string const value = UniformLiteral(_uniform.type, _data);
+    if (name.empty() || value.empty())
+        return false;
+
+    auto const is_identifier = [](char const _c) {
+        return std::isalnum(static_cast<unsigned char>(_c)) || _c == '_';
+    };
+    auto const skip_blanks = [&io_source](std::size_t _position) {
+        return std::min(io_source.find_first_not_of(" \t", _position), io_source.size());
+    };
+    auto const match_word = [&io_source, &is_identifier](std::size_t _position, std::string const &_word) {
+        return io_source.compare(_position, _word.size(), _word) == 0 &&
+            (_position + _word.size() >= io_source.size() || !is_identifier(io_source[_position + _word.size()]));
+    };
+
+    static std::string const kUniform{ "uniform" };
+    std::string const type_name{ UniformTypeName(_uniform.type) };
+    for (std::size_t begin = io_source.find(kUniform); begin != std::string::npos;
+         begin = io_source.find(kUniform, begin + 1u))
+    {
+        if ((begin > 0u && is_identifier(io_source[begin - 1u])) || !match_word(begin, kUniform))
+            continue;
+
+        std::size_t position = skip_blanks(begin + kUniform.size());
+        if (!match_word(position, type_name))
+            continue;
+        position = skip_blanks(position + type_name.size());
+        if (!match_word(position, name))
+            continue;
+        position = skip_blanks(position + name.size());
+        if (position >= io_source.size() || io_source[position] != ';')
+            continue;
+
+        // On the line of the declaration so that error lines don't move.
+        io_source.replace(begin, position - begin, "const " + type_name + " " + name + " = " + value);
+        return true;
+    }
+    return false;
+}
+
+
+std::string
+RenderContext::Impl_::InsertLoopCosts(std::string const &_source)
+{
+    auto const is_identifier = [](char const _c) {
+        return std::isalnum(static_cast<unsigned char>(_c)) || _c == '_';
+    };
+    auto const skip_blanks = [&_source](std::size_t _position) {
+        return std::min(_source.find_first_not_of(" \t\r\n", _position), _source.size());
+    };
+    static std::string const kLoopCost{ " " SR_SL_COST_MACRO "(1);" };
+
+    std::string result{};
+    result.reserve(_source.size());
+    std::size_t position = 0u;
+    while (position < _source.size())
+    {
+        std::size_t next = position + 1u;
+        if (_source.compare(position, 2u, "//") == 0)
+        {
+            next = std::min(_source.find('\n', position), _source.size());
+        }
+        else if (_source.compare(position, 2u, "/*") == 0)
+        {
+            std::size_t const comment_end = _source.find("*/", position + 2u);
+            next = (comment_end == std::string::npos) ? _source.size() : comment_end + 2u;
+        }
+        else if (is_identifier(_source[position]))
+        {
+            next = position;
+            while (next < _source.size() && is_identifier(_source[next]))
+                ++next;
+
+            // The body brace of "for (...) {", "while (...) {" and "do {",
+            // loops without braces are left alone.
+            std::string const word = _source.substr(position, next - position);
+            std::size_t body = skip_blanks(next);
+            if ((word == "for" || word == "while") && body < _source.size() && _source[body] == '(')
+            {
+                int depth = 0;
+                for (; body < _source.size(); ++body)
+                {
+                    if (_source[body] == '(')
+                        ++depth;
+                    else if (_source[body] == ')' && --depth == 0)
+                        break;
+                }
+                body = skip_blanks(body + 1u);
+            }
+            else if (word != "do")
+            {
+                body = _source.size();
+            }
+
+            if (body < _source.size() && _source[body] == '{')
+            {
+                result.append(_source, position, body + 1u - position);
+                result += kLoopCost;
+                position = body + 1u;
+                continue;
+            }
+        }
+
+        result.append(_source, position, next - position);
+        position = next;
+    }
+    return result;
+}
+
+
+void
+RenderContext::Impl_::UpdateSpecialization()
+{
+    Specialization &state = specialization_;
+    // The generic program is about to change, the specialization would be
+    // thrown away anyway. Same when it predates an execution mode switch.
+    if (!state.enabled || kernels_build_ ||
+        shader_program_.compute != compute_.enabled ||
+        shader_program_.cost_profiled != cost_.enabled ||
+        shader_program_.temporal_hits != temporal_.enabled)
+        return;
+
+    if (state.building)
+    {
+        PollSpecialization();
+        return;
+    }
+
+    utility::Clock::StdClock_t::time_point const now = utility::Clock::StdClock_t::now();
+    FrozenUniforms_t idle{};
+    for (std::size_t i = 0; i < uniforms_.size(); ++i)
+    {
+        if (std::chrono::duration<float>(now - state.change_times[i]).count() >= state.delay)
+        {
+            std::uint32_t const *value = static_cast<std::uint32_t const*>(uniforms_.data(i));
+            idle.emplace_back(i, UniformValue_t(value, value + UniformComponentCount(uniforms_[i].type)));
+        }
+    }
+    if (idle == state.requested)
+        return;
+    state.requested = idle;
+
+    std::string source = kernel_sources_[static_cast<std::size_t>(ShaderStage::kFragment)];
+    state.pending_frozen.clear();
+    for (std::pair<std::size_t, UniformValue_t> const &uniform : idle)
+    {
+        if (FreezeUniform(source, uniforms_[uniform.first], uniform.second.data()))
+            state.pending_frozen.push_back(uniform);
+    }
+    if (state.pending_frozen == state.frozen)
+        return;
+    if (state.pending_frozen.empty())
+    {
+        RetireProgram(state.program);
+        state.program = KernelProgram{};
+        state.frozen.clear();
+        return;
+    }
+
+    state.kernels.clear();
+    state.kernels.push_back(PendingKernel{
+        ShaderStage::kFragment, std::string{}, std::move(source), oglbase::ShaderPtr{ 0u }, PreprocessedKernel{}
+    });
+    state.program_key = ProgramKey(state.kernels);
+    state.pending_program = shader_cache_.TakeProgram(state.program_key);
+    state.from_memory = state.pending_program;
+    state.compiled = state.from_memory;
+    state.building = true;
+    if (state.from_memory)
+        return;
+
+    // Stages restored from a program binary have no shader object yet.
+    for (ShaderStage stage : active_stages_)
+    {
+        if (stage != ShaderStage::kFragment && !shader_cache_[stage])
+        {
+            state.kernels.push_back(PendingKernel{
+                stage, std::string{}, kernel_sources_[static_cast<std::size_t>(stage)],
+                oglbase::ShaderPtr{ 0u }, PreprocessedKernel{}
+            });
+        }
+    }
+    for (PendingKernel &kernel : state.kernels)
+        BeginKernelCompile(kernel);
+}
+
+
+void
+RenderContext::Impl_::PollSpecialization()
+{
+    Specialization &state = specialization_;
+    auto const abort_build = [&state]() {
+        state.building = false;
+        state.kernels.clear();
+        state.pending_program = oglbase::ProgramPtr{ 0u };
+    };
+
+    if (!state.compiled)
+    {
+        bool const compile_done = std::all_of(state.kernels.cbegin(), state.kernels.cend(),
+                                              [](PendingKernel const& _kernel) {
+                                                  return oglbase::IsShaderReady(_kernel.shader);
+                                              });
+        if (!compile_done)
+            return;
+
+        for (PendingKernel &kernel : state.kernels)
+        {
+            if (!oglbase::EndCompileShader(kernel.shader, nullptr))
+            {
+                std::cout << "Uniform specialization compilation failed" << std::endl;
+                abort_build();
+                return;
+            }
+        }
+
+        oglbase::ShaderBinaries_t binaries{};
+        for (ShaderStage stage : active_stages_)
+        {
+            auto const kernel_it = std::find_if(state.kernels.cbegin(), state.kernels.cend(),
+                                                [stage](PendingKernel const& _kernel) {
+                                                    return _kernel.stage == stage;
+                                                });
+            binaries.emplace_back((kernel_it != state.kernels.cend())
+                                  ? static_cast<GLuint>(kernel_it->shader)
+                                  : static_cast<GLuint>(shader_cache_[stage]));
+        }
+        state.pending_program = oglbase::BeginLinkProgram(binaries, program_binary_cache_.enabled());
+        state.compiled = true;
+    }
+
+    if (!oglbase::IsProgramReady(state.pending_program))
+        return;
+    if (!oglbase::EndLinkProgram(state.pending_program))
+    {
+        std::cout << "Uniform specialization link failed" << std::endl;
+        abort_build();
+        return;
+    }
+
+    // Generic stages compiled along the way are the live kernel sources.
+    for (PendingKernel &kernel : state.kernels)
+    {
+        if (kernel.stage != ShaderStage::kFragment)
+            shader_cache_.Install(kernel.stage, std::move(kernel.shader), kernel.shader_key);
+    }
+
+    std::cout << "Specialized program with " << state.pending_frozen.size()
+              << " frozen uniform(s)" << std::endl;
+    RetireProgram(state.program);
+    SetProgram(state.program, std::move(state.pending_program));
+    state.program.program_key = state.program_key;
+    state.program.compute = compute_.enabled;
+    state.program.cost_profiled = cost_.enabled;
+    state.program.temporal_hits = temporal_.enabled;
+    state.frozen = std::move(state.pending_frozen);
+    state.pending_frozen.clear();
+    abort_build();
+}
+
+
+void
+RenderContext::Impl_::ResetSpecialization()
+{
+    Specialization &state = specialization_;
+    RetireProgram(state.program);
+    state.program = KernelProgram{};
+    state.frozen.clear();
+    state.requested.clear();
+    state.pending_frozen.clear();
+    state.building = false;
+    state.kernels.clear();
+    state.pending_program = oglbase::ProgramPtr{ 0u };
+    state.change_times.assign(uniforms_.size(), utility::Clock::StdClock_t::now());
+}
+
+
+void
+RenderContext::Impl_::OnUniformChanged(std::size_t _index)
+{
+    Specialization &state = specialization_;
+    state.change_times[_index] = utility::Clock::StdClock_t::now();
+
+    auto const is_frozen = [_index](FrozenUniforms_t const &_uniforms) {
+        return std::any_of(_uniforms.cbegin(), _uniforms.cend(),
+                           [_index](std::pair<std::size_t, UniformValue_t> const& _uniform) {
+                               return _uniform.first == _index;
+                           });
+    };
+    if (is_frozen(state.frozen))
+    {
+        RetireProgram(state.program);
+        state.program = KernelProgram{};
+        state.frozen.clear();
+    }
+    if (state.building && is_frozen(state.pending_frozen))
+    {
+        state.building = false;
+        state.kernels.clear();
+        state.pending_program = oglbase::ProgramPtr{ 0u };
+        state.pending_frozen.clear();
+    }
+}
+
+
+void
+RenderContext::Impl_::ResizeOffscreenTarget(std::array<GLsizei, 2> const &_size)
+{
+    OffscreenTarget &target = offscreen_;
+    if (target.framebuffer && target.size == _size)
+        return;
+
+    target.size = _size;
+    target.framebuffer = std::make_unique<oglbase::Framebuffer>(
+        _size[0], _size[1],
+        oglbase::Framebuffer::AttachmentDescs{ { GL_COLOR_ATTACHMENT0, GL_RGBA8 } },
+        false);
+
+    GLsizeiptr const frame_size = static_cast<GLsizeiptr>(_size[0]) * _size[1] * 4;
+    for (oglbase::BufferPtr &buffer : target.readback_buffers)
+    {
+        if (!buffer)
+            glGenBuffers(1, buffer.get());
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frame_size, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0u);
+}
+
+
+void
+RenderContext::Impl_::SetUniformValue(std::size_t _index, void const *_data)
+{
+    if (_index >= uniforms_.size() || !uniforms_.Set(_index, _data))
+        return;
+
+    OnUniformChanged(_index);
+    progressive_.next_tile = 0;
+    accumulation_.sample_count = 0;
+    ForEachProgram([_index](KernelProgram &_program) {
+        _program.uniform_bindings[_index].dirty = true;
+    });
+}
+
+
+RenderContext::Impl_::KernelProgram &
+RenderContext::Impl_::ActiveProgram()
+{
+    return specialization_.program.program ? specialization_.program : shader_program_;
+}
+
+
+std::string const &
+RenderContext::Impl_::KernelSource(std::vector<PendingKernel> const &_overrides,
+                                   ShaderStage _stage) const
+{
+    auto const override_it = std::find_if(_overrides.cbegin(), _overrides.cend(),
+                                          [_stage](PendingKernel const& _kernel) {
+                                              return _kernel.stage == _stage;
+                                          });
+    return (override_it != _overrides.cend())
+        ? override_it->source
+        : kernel_sources_[static_cast<std::size_t>(_stage)];
+}
+
+
+utility::Hash_t
+RenderContext::Impl_::ProgramKey(std::vector<PendingKernel> const &_overrides) const
+{
+    utility::Hash_t result = utility::kHashSeed;
+    for (ShaderStage stage : active_stages_)
+    {
+        ShaderStage const execution_stage = ExecutionStage(stage);
+        std::string const stage_source = ExecutionSource(stage, KernelSource(_overrides, stage));
+
+        result = StageKey(execution_stage, stage_source, result);
+    }
+    return result;
+}
+
+
+utility::Hash_t
+RenderContext::Impl_::StageKey(ShaderStage _execution_stage, std::string const &_stage_source, utility::Hash_t _seed)
+{
+    utility::Hash_t result = utility::HashValue(ShaderStageToGLenum(_execution_stage), _seed);
+    for (char const* source : AssembleKernel(_execution_stage, { _stage_source.c_str() }))
+        result = utility::HashString(source, result);
+    return result;
+}
+
+
+utility::Hash_t
+RenderContext::Impl_::BufferPassKey(std::string const &_pass_source)
+{
+    std::string const vertex_source = JoinSources(DefaultKernel(ShaderStage::kVertex));
+
+    utility::Hash_t result = utility::kHashSeed;
+    result = utility::HashValue(GL_VERTEX_SHADER, result);
+    for (char const* source : AssembleKernel(ShaderStage::kVertex, { vertex_source.c_str() }))
+        result = utility::HashString(source, result);
+    result = utility::HashValue(GL_FRAGMENT_SHADER, result);
+    for (char const* source : AssembleKernel(ShaderStage::kFragment, { _pass_source.c_str() }))
+        result = utility::HashString(source, result);
+    return result;
+}
+
+
+void
+RenderContext::Impl_::SetProgram(KernelProgram &_target, oglbase::ProgramPtr &&_program)
+{
+    _target.program = std::move(_program);
+    _target.uniform_table = oglbase::ReflectUniforms(_target.program);
+
+    BuiltinBindings &builtin_bindings = _target.builtin_bindings;
+    builtin_bindings.compute_rect = oglbase::FindUniform(_target.uniform_table, SR_SL_COMPUTE_RECT_UNIFORM);
+    _target.builtins_dirty = true;
+
+    // iChannelN always samples texture unit N.
+    for (std::size_t i = 0; i < kBufferPassCountMax; ++i)
+    {
+        std::string const channel_name = SR_SL_CHANNEL_UNIFORM + std::to_string(i);
+        GLint const location = oglbase::FindUniform(_target.uniform_table, channel_name.c_str());
+        if (location >= 0)
+            glProgramUniform1i(_target.program, location, static_cast<GLint>(i));
+    }
+    GLint const prev_hits_location = oglbase::FindUniform(_target.uniform_table, SR_SL_PREV_HITS_UNIFORM);
+    if (prev_hits_location >= 0)
+        glProgramUniform1i(_target.program, prev_hits_location, SR_PREV_HITS_TEXTURE_UNIT);
+    GLint const ray_start_location = oglbase::FindUniform(_target.uniform_table, SR_SL_RAY_START_UNIFORM);
+    if (ray_start_location >= 0)
+        glProgramUniform1i(_target.program, ray_start_location, SR_RAY_START_TEXTURE_UNIT);
+
+    BindUniforms(_target);
+}
+
+
+void
+RenderContext::Impl_::BindUniforms(KernelProgram &_target)
+{
+    std::vector<UniformBinding> &uniform_bindings = _target.uniform_bindings;
+    uniform_bindings.clear();
+    uniform_bindings.reserve(uniforms_.size());
+    for (std::size_t i = 0; i < uniforms_.size(); ++i)
+    {
+        // A declaration of another type is left alone, as GL would reject
+        // the upload anyway.
+        UniformStore::Uniform const &uniform = uniforms_[i];
+        auto const desc_it = _target.uniform_table.find(uniform.name);
+        bool const matches = desc_it != _target.uniform_table.cend() &&
+            desc_it->second.type == UniformTypeToGLenum(uniform.type);
+        uniform_bindings.push_back(UniformBinding{ matches ? desc_it->second.location : -1, true });
+    }
+}
+
+
+void
+RenderContext::Impl_::UploadUniforms(KernelProgram &_target, float _time, Jitter_t const &_jitter)
+{
+    static_assert(sizeof(Vec3_t) == 3 * sizeof(float), "");
+
+    BindFrameUniforms(_time, _jitter);
+    _target.builtins_dirty = false;
+
+    assert(_target.uniform_bindings.size() == uniforms_.size());
+    for (std::size_t i = 0; i < _target.uniform_bindings.size(); ++i)
+    {
+        UniformBinding &binding = _target.uniform_bindings[i];
+        if (binding.dirty && binding.location >= 0)
+            UploadUniform(binding.location, uniforms_[i].type, uniforms_.data(i));
+        binding.dirty = false;
+    }
+}
+
+
+template <typename Function>
+void
+RenderContext::Impl_::ForEachProgram(Function &&_function)
+{
+    _function(shader_program_);
+    if (specialization_.program.program)
+        _function(specialization_.program);
+    for (std::unique_ptr<BufferPass> &pass : buffer_passes_)
+    {
+        if (pass)
+            _function(pass->program);
+    }
+    if (crossfade_.program.program)
+        _function(crossfade_.program);
+    for (std::unique_ptr<BufferPass> &pass : crossfade_.passes)
+    {
+        if (pass)
+            _function(pass->program);
+    }
+}
+
+
+bool
+RenderContext::Impl_::ParsePassMarker(std::string const &_line, int *o_pass)
+{
+    static std::size_t const kPragmaLength = std::strlen(SR_SL_PASS_PRAGMA);
+
+    std::size_t const begin = _line.find_first_not_of(" \t");
+    if (begin == std::string::npos || _line.compare(begin, kPragmaLength, SR_SL_PASS_PRAGMA) != 0)
+        return false;
+
+    std::string pass_name{};
+    std::istringstream{ _line.substr(begin + kPragmaLength) } >> pass_name;
+
+    static std::string const kBufferPrefix{ "buffer" };
+    if (pass_name == "image")
+    {
+        *o_pass = kImagePass;
+    }
+    else if (pass_name == "prepass")
+    {
+        *o_pass = static_cast<int>(kDepthPrepass);
+    }
+    else if (pass_name.size() == kBufferPrefix.size() + 1u &&
+             pass_name.compare(0, kBufferPrefix.size(), kBufferPrefix) == 0 &&
+             pass_name.back() >= '0' &&
+             pass_name.back() < '0' + static_cast<int>(kBufferPassCountMax))
+    {
+        *o_pass = pass_name.back() - '0';
+    }
+    else
+    {
+        *o_pass = kUnknownSection;
+    }
+    return true;
+}
+
+
+std::string
+RenderContext::Impl_::PassSource(std::string const &_kernel, int _pass)
+{
+    std::string result{};
+    result.reserve(_kernel.size());
+
+    int section = kSharedSection;
+    for (std::size_t line_begin = 0u; line_begin < _kernel.size();)
+    {
+        std::size_t line_end = _kernel.find('\n', line_begin);
+        line_end = (line_end == std::string::npos) ? _kernel.size() : line_end + 1u;
+        std::string const line = _kernel.substr(line_begin, line_end - line_begin);
+        line_begin = line_end;
+
+        bool const is_marker = ParsePassMarker(line, &section);
+        if (!is_marker && (section == kSharedSection || section == _pass))
+            result += line;
+        else if (line.back() == '\n')
+            result += '\n';
+    }
+    // Appended so that its line numbers are left untouched.
+    if (_pass == static_cast<int>(kDepthPrepass))
+        result += "\n#define SR_DEPTH_PREPASS 1\n";
+    return result;
+}
+
+
+std::set<int>
+RenderContext::Impl_::DeclaredBufferPasses(std::string const &_kernel)
+{
+    std::set<int> result{};
+    std::istringstream stream{ _kernel };
+    for (std::string line; std::getline(stream, line);)
+    {
+        int pass = kSharedSection;
+        if (!ParsePassMarker(line, &pass))
+            continue;
+        if (pass >= 0)
+            result.insert(pass);
+        else if (pass == kUnknownSection)
+            std::cout << "Unknown kernel pass: " << line << std::endl;
+    }
+    return result;
+}
+
+
+std::string
+RenderContext::Impl_::StageSource(ShaderStage _stage, std::string const &_kernel)
+{
+    return (_stage == ShaderStage::kFragment) ? PassSource(_kernel, kImagePass) : _kernel;
+}
+
+
+void
+RenderContext::Impl_::OnExecutionModeChanged()
+{
+    kernels_build_.reset();
+    for (PlaylistEntry &entry : playlist_)
+    {
+        entry.build.reset();
+        entry.failed = false;
+    }
+    ResetSpecialization();
+
+    if (kernel_files_.count(ShaderStage::kFragment) != 0)
+    {
+        changed_kernels_.insert(ShaderStage::kFragment);
+        KernelsUpdate();
+    }
+}
+
+
+ShaderStage
+RenderContext::Impl_::ExecutionStage(ShaderStage _stage) const
+{
+    return (compute_.enabled && _stage == ShaderStage::kFragment) ? ShaderStage::kCompute : _stage;
+}
+
+
+std::string
+RenderContext::Impl_::ExecutionSource(ShaderStage _stage, std::string const &_kernel) const
+{
+    std::string result = StageSource(_stage, _kernel);
+    if (_stage != ShaderStage::kFragment)
+        return result;
+
+    if (cost_.enabled)
+    {
+        result = InsertLoopCosts(result);
+        result += kCostProfiling;
+    }
+    if (temporal_.enabled)
+        result += kTemporalHits;
+    if (ExecutionStage(_stage) != ShaderStage::kCompute)
+        return result;
+
+    // Appended to the kernel so that its line numbers are left untouched.
+    ComputeExecution const &state = compute_;
+    std::ostringstream defines{};
+    defines << "\n#define SR_WORKGROUP_SIZE_X " << state.workgroup_size[0]
+            << "\n#define SR_WORKGROUP_SIZE_Y " << state.workgroup_size[1]
+            << "\n#define SR_MORTON_ORDER " << ((state.tile_order == ComputeTileOrder::kMorton) ? 1 : 0)
+            << "\n#define SR_MORTON_BLOCK_SIZE " << kMortonBlockSize << "u\n";
+    result += defines.str();
+    return result;
+}
+
+
+oglbase::ShaderSources_t
+RenderContext::Impl_::AssembleKernel(ShaderStage _stage, oglbase::ShaderSources_t const &_kernel_sources)
+{
+    static oglbase::ShaderSources_t const kKernelPrefix{
+        SR_GLSL_VERSION,
+        // Laid out as FrameBlock.
+        "layout(std140, binding = " SR_STRINGIFY(SR_FRAME_BINDING) ") uniform " SR_SL_FRAME_BLOCK " {"
+            " mat4 " SR_SL_PROJMAT_UNIFORM "; mat4 " SR_SL_INV_PROJMAT_UNIFORM "; mat4 " SR_SL_PREV_PROJMAT_UNIFORM ";"
+            " vec2 " SR_SL_RESOLUTION_UNIFORM "; vec2 " SR_SL_JITTER_UNIFORM "; float " SR_SL_TIME_UNIFORM ";"
+            " int " SR_SL_GIZMO_COUNT_UNIFORM "; float " SR_SL_PREPASS_TILE_UNIFORM "; };\n",
+
+        "uniform sampler2D " SR_SL_CHANNEL_UNIFORM "0, " SR_SL_CHANNEL_UNIFORM "1, "
+                             SR_SL_CHANNEL_UNIFORM "2, " SR_SL_CHANNEL_UNIFORM "3;\n",
+    };
+    // Storage blocks are only guaranteed in fragment and compute shaders, other
+    // stages get blank lines instead of them, of the cost counter and of the
+    // temporal hit helpers so that kernel line numbers are the same everywhere.
+    static oglbase::ShaderSources_t const kFragmentStorage{
+        "layout(std430, binding = " SR_STRINGIFY(SR_GIZMOS_BINDING) ") readonly buffer SRGizmos { vec3 "
+            SR_SL_GIZMOS_BUFFER "[]; };\n",
+        "layout(std430, binding = " SR_STRINGIFY(SR_GIZMO_PARAMS_BINDING) ") readonly buffer SRGizmoParams { vec4 "
+            SR_SL_GIZMO_PARAMS_BUFFER "[]; };\n",
+        // Dead code unless the entry point stores it, see kCostProfiling.
+        "uint sr_cost = 0u;\n",
+        "#define " SR_SL_COST_MACRO "(n) (sr_cost += uint(n))\n",
+        // Defined after the kernel, see kTemporalHits.
+        "uniform sampler2D " SR_SL_PREV_HITS_UNIFORM ";\n",
+        "float srRayStart(vec3 ray_origin, vec3 ray_direction);"
+            " void srSetHit(vec3 ray_origin, vec3 ray_direction, float hit_distance);\n",
+        // Unbound, and so 0, while there is no depth prepass.
+        "uniform sampler2D " SR_SL_RAY_START_UNIFORM ";"
+            " float srPrepassStart(vec2 frag_coord) { return texelFetch(" SR_SL_RAY_START_UNIFORM ","
+            " ivec2(frag_coord / max(" SR_SL_PREPASS_TILE_UNIFORM ", 1.0)), 0).r; }\n",
+    };
+    static oglbase::ShaderSources_t const kNoStorage{ "\n", "\n", "\n", "\n", "\n", "\n", "\n" };
+    oglbase::ShaderSources_t const &kernel_storage =
+        (_stage == ShaderStage::kFragment || _stage == ShaderStage::kCompute) ? kFragmentStorage : kNoStorage;
+    oglbase::ShaderSources_t const &kernel_suffix = KernelSuffix(_stage);
+
+    oglbase::ShaderSources_t shader_sources{};
+    shader_sources.reserve(kKernelPrefix.size() + kernel_storage.size() +
+                           _kernel_sources.size() + kernel_suffix.size());
+    std::copy(kKernelPrefix.cbegin(), kKernelPrefix.cend(), std::back_inserter(shader_sources));
+    std::copy(kernel_storage.cbegin(), kernel_storage.cend(), std::back_inserter(shader_sources));
+    assert(shader_sources.size() == static_cast<std::size_t>(kKernelPrefixLines));
+    std::copy(_kernel_sources.cbegin(), _kernel_sources.cend(), std::back_inserter(shader_sources));
+    std::copy(kernel_suffix.cbegin(), kernel_suffix.cend(), std::back_inserter(shader_sources));
+    return shader_sources;
+}
+
+
+ErrorLogContainer
+RenderContext::Impl_::ParseErrorLog(std::string _error_msg)
+{
+    ErrorLogContainer errorlog;
+    while (!_error_msg.empty())
+    {
+        std::string head = [](std::string &_in){
+            std::size_t index = _in.find('\n');
+            std::string head = _in.substr(0, index);
+            _in = _in.substr(index+1);
+            return head;
+        }(_error_msg);
+
+        int line_index = 0;
+        std::string message = head;
+        {
+            std::size_t const linenum_begin = head.find(':') + 1;
+            std::size_t const linenum_end = head.find(':', linenum_begin) + 1;
+            std::size_t const paren_begin = head.find('(', linenum_begin);
+            std::size_t const message_begin = head.find(':', linenum_end);
+
+            if (linenum_begin != ~0ull &&
+                linenum_end != ~0ull &&
+                paren_begin != ~0ull &&
+                message_begin != ~0ull)
+            {
+                message = head.substr(message_begin+2);
+                line_index = std::stoi(head.substr(linenum_begin, paren_begin-linenum_begin)) - kKernelPrefixLines;
+            }
+        }
+
+        errorlog.emplace_back(std::make_pair(line_index, message));
+    }
+    return errorlog;
+}
+
+
+std::string
+RenderContext::Impl_::JoinSources(oglbase::ShaderSources_t const &_sources)
+{
+    std::string result{};
+    for (char const* source : _sources)
+        result += source;
+    return result;
+}
+
+
+std::pair<oglbase::ShaderPtr, ErrorLogContainer>
+RenderContext::Impl_::CompileKernel(ShaderStage _stage, oglbase::ShaderSources_t const &_kernel_sources)
+{
+    std::string error_msg;
+    ErrorLogContainer errorlog;
+    oglbase::ShaderPtr shader = oglbase::CompileShader(ShaderStageToGLenum(_stage),
+                                                       AssembleKernel(_stage, _kernel_sources),
+                                                       &error_msg);
+    if (!shader)
+        errorlog = ParseErrorLog(std::move(error_msg));
+    return std::make_pair(std::move(shader), std::move(errorlog));
+}
+
+
+void
+RenderContext::Impl_::DrawKernel(KernelProgram const &_program)
+{
+    if (_program.compute)
+    {
+        DispatchKernel(_program);
+        return;
+    }
+
+#ifdef SR_GEOMETRY_RENDERING
+    glBindVertexArray(vao_);
+    glDrawArrays(GL_POINTS, 0, point_count_);
+    glBindVertexArray(0u);
+#else
+    glBindVertexArray(dummy_vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0u);
+#endif
+}
+
+
+void
+RenderContext::Impl_::DispatchKernel(KernelProgram const &_program)
+{
+    ComputeExecution &state = compute_;
+    std::array<GLsizei, 2> const size{ static_cast<GLsizei>(render_resolution_[0]),
+                                       static_cast<GLsizei>(render_resolution_[1]) };
+    if (size[0] <= 0 || size[1] <= 0)
+        return;
+
+    if (state.present_failed)
+        return;
+
+    // The output is drawn to the framebuffer of the caller, which may have
+    // bound channels and expects its program to stay current. Creating the
+    // target unbinds both, they are restored before any early exit.
+    GLint framebuffer = 0;
+    GLint channel_texture = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    glActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &channel_texture);
+
+    if (!state.target || state.target_size != size)
+    {
+        oglbase::Framebuffer::AttachmentDescs const attachments{
+            { GL_COLOR_ATTACHMENT0, GL_RGBA16F }
+        };
+        state.target = std::make_unique<oglbase::Framebuffer>(size[0], size[1], attachments, false);
+        state.target_size = size;
+        glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(channel_texture));
+    }
+
+    if (!state.present_program)
+    {
+        if (!buffer_vertex_shader_)
+            buffer_vertex_shader_ = CompileKernel(ShaderStage::kVertex, DefaultKernel(ShaderStage::kVertex)).first;
+        oglbase::ShaderPtr const present_shader = CompileKernel(ShaderStage::kFragment, { kComputePresentKernel }).first;
+        if (buffer_vertex_shader_ && present_shader)
+            state.present_program = oglbase::LinkProgram({ buffer_vertex_shader_, present_shader });
+        if (!state.present_program)
+        {
+            std::cout << "Compute present program build failed" << std::endl;
+            state.present_failed = true;
+            return;
+        }
+    }
+
+    // Progressive tiles are scissored, only their workgroups are dispatched.
+    std::array<GLint, 4> rect{ 0, 0, size[0], size[1] };
+    if (glIsEnabled(GL_SCISSOR_TEST))
+    {
+        std::array<GLint, 4> scissor{};
+        glGetIntegerv(GL_SCISSOR_BOX, scissor.data());
+        rect[0] = std::max(scissor[0], 0);
+        rect[1] = std::max(scissor[1], 0);
+        rect[2] = std::min(scissor[0] + scissor[2], size[0]) - rect[0];
+        rect[3] = std::min(scissor[1] + scissor[3], size[1]) - rect[1];
+        if (rect[2] <= 0 || rect[3] <= 0)
+            return;
+    }
+
+    GLuint const columns = (static_cast<GLuint>(rect[2]) + static_cast<GLuint>(state.workgroup_size[0]) - 1u) /
+        static_cast<GLuint>(state.workgroup_size[0]);
+    GLuint const rows = (static_cast<GLuint>(rect[3]) + static_cast<GLuint>(state.workgroup_size[1]) - 1u) /
+        static_cast<GLuint>(state.workgroup_size[1]);
+    GLuint const workgroup_count = (state.tile_order == ComputeTileOrder::kMorton)
+        ? ((columns + kMortonBlockSize - 1u) / kMortonBlockSize) *
+          ((rows + kMortonBlockSize - 1u) / kMortonBlockSize) * kMortonBlockSize * kMortonBlockSize
+        : columns * rows;
+
+    // Workgroups are numbered row by row over a kDispatchWidth wide grid, the
+    // kernel maps that index to its tile.
+    if (_program.builtin_bindings.compute_rect >= 0)
+        glUniform4iv(_program.builtin_bindings.compute_rect, 1, rect.data());
+    glBindImageTexture(0u, state.target->texture(0), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+    glDispatchCompute(std::min(workgroup_count, kDispatchWidth),
+                      (workgroup_count + kDispatchWidth - 1u) / kDispatchWidth, 1u);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    glBindImageTexture(0u, 0u, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+    // Drawn with the blending and scissor state of the caller.
+    glBindTexture(GL_TEXTURE_2D, state.target->texture(0));
+    glUseProgram(state.present_program);
+    glBindVertexArray(dummy_vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0u);
+    glUseProgram(_program.program);
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(channel_texture));
+}
+
+
+void
+RenderContext::Impl_::BeginCostFrame()
+{
+    CostProfiling &state = cost_;
+    std::array<GLsizei, 2> const size{ static_cast<GLsizei>(render_resolution_[0]),
+                                       static_cast<GLsizei>(render_resolution_[1]) };
+    if (size[0] <= 0 || size[1] <= 0)
+        return;
+
+    GLsizei const tile_columns = (size[0] + SR_COST_TILE_SIZE - 1) / SR_COST_TILE_SIZE;
+    GLsizei const tile_rows = (size[1] + SR_COST_TILE_SIZE - 1) / SR_COST_TILE_SIZE;
+    std::size_t const tile_count = static_cast<std::size_t>(tile_columns * tile_rows);
+    GLsizeiptr const buffer_size = static_cast<GLsizeiptr>((2u + tile_count) * sizeof(GLuint));
+
+    std::vector<GLuint> values(2u + tile_count, 0u);
+    if (state.size == size && state.readback.Read(values.data(), buffer_size) == buffer_size)
+    {
+        CostStats &stats = state.stats;
+        stats.total = values[0];
+        stats.max = values[1];
+        stats.mean = static_cast<float>(values[0]) / static_cast<float>(size[0] * size[1]);
+        stats.tile_size = SR_COST_TILE_SIZE;
+
+        std::vector<CostTile> tiles{};
+        tiles.reserve(tile_count);
+        for (std::size_t i = 0; i < tile_count; ++i)
+        {
+            int const column = static_cast<int>(i % static_cast<std::size_t>(tile_columns));
+            int const row = static_cast<int>(i / static_cast<std::size_t>(tile_columns));
+            tiles.push_back(CostTile{ column * SR_COST_TILE_SIZE, row * SR_COST_TILE_SIZE, values[2u + i] });
+        }
+        std::size_t const hot_count = std::min(kHotTileCount, tiles.size());
+        std::partial_sort(tiles.begin(), tiles.begin() + static_cast<std::ptrdiff_t>(hot_count), tiles.end(),
+                          [](CostTile const& _lhs, CostTile const& _rhs) {
+                              return _lhs.cost > _rhs.cost;
+                          });
+        tiles.resize(hot_count);
+        stats.hot_tiles = std::move(tiles);
+    }
+
+    if (!state.image || state.size != size)
+    {
+        state.image = oglbase::TexturePtr{ 0u };
+        glGenTextures(1, state.image.get());
+        glBindTexture(GL_TEXTURE_2D, state.image);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, size[0], size[1]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0u);
+        glClearTexImage(state.image, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+        state.buffer = oglbase::BufferPtr{ 0u };
+        glGenBuffers(1, state.buffer.get());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, state.buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, buffer_size, nullptr, GL_DYNAMIC_COPY);
+        state.buffer_size = buffer_size;
+        state.readback.Reset();
+        state.size = size;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, state.buffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0u);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SR_COST_BINDING, state.buffer);
+    glBindImageTexture(SR_COST_IMAGE_UNIT, state.image, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+    state.pending = true;
+}
+
+
+void
+RenderContext::Impl_::RenderCostHeatmap(GLuint _kernel_framebuffer)
+{
+    CostProfiling &state = cost_;
+    if (!state.pending)
+        return;
+
+    glBindImageTexture(SR_COST_IMAGE_UNIT, 0u, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    state.readback.Capture(state.buffer, state.buffer_size);
+    if (state.heatmap_opacity <= 0.f)
+        return;
+
+    if (!state.heatmap_program)
+    {
+        if (!buffer_vertex_shader_)
+            buffer_vertex_shader_ = CompileKernel(ShaderStage::kVertex, DefaultKernel(ShaderStage::kVertex)).first;
+        oglbase::ShaderPtr const heatmap_shader = CompileKernel(ShaderStage::kFragment, { kCostHeatmapKernel }).first;
+        if (!heatmap_shader)
+            return;
+        state.heatmap_program = oglbase::LinkProgram({ buffer_vertex_shader_, heatmap_shader });
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _kernel_framebuffer);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, state.image);
+    glEnable(GL_BLEND);
+    glBlendColor(0.f, 0.f, 0.f, std::min(state.heatmap_opacity, 1.f));
+    glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    glUseProgram(state.heatmap_program);
+    glBindVertexArray(dummy_vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0u);
+    glUseProgram(0u);
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0u);
+}
+
+
+void
+RenderContext::Impl_::BeginTemporalFrame()
+{
+    TemporalHits &state = temporal_;
+    std::array<GLsizei, 2> const size{ static_cast<GLsizei>(render_resolution_[0]),
+                                       static_cast<GLsizei>(render_resolution_[1]) };
+    if (size[0] <= 0 || size[1] <= 0)
+        return;
+
+    if (!state.hits[0] || state.size != size)
+    {
+        for (oglbase::TexturePtr &hits : state.hits)
+        {
+            hits = oglbase::TexturePtr{ 0u };
+            glGenTextures(1, hits.get());
+            glBindTexture(GL_TEXTURE_2D, hits);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32F, size[0], size[1]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glBindTexture(GL_TEXTURE_2D, 0u);
+            glClearTexImage(hits, 0, GL_RGBA, GL_FLOAT, nullptr);
+        }
+        state.size = size;
+    }
+    else if (progressive_.enabled)
+    {
+        glClearTexImage(state.hits[1], 0, GL_RGBA, GL_FLOAT, nullptr);
+    }
+
+    glActiveTexture(GL_TEXTURE0 + SR_PREV_HITS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, state.hits[1]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindImageTexture(SR_HITS_IMAGE_UNIT, state.hits[0], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+}
+
+
+void
+RenderContext::Impl_::EndTemporalFrame()
+{
+    TemporalHits &state = temporal_;
+    glBindImageTexture(SR_HITS_IMAGE_UNIT, 0u, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA32F);
+    glActiveTexture(GL_TEXTURE0 + SR_PREV_HITS_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, 0u);
+    glActiveTexture(GL_TEXTURE0);
+    if (!state.hits[0])
+        return;
+
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    std::swap(state.hits[0], state.hits[1]);
+    state.previous_projection = context_.projection_matrix;
+}
+
+
+void
+RenderContext::Impl_::RenderTiles(float _time)
+{
+    ProgressiveState &state = progressive_;
+    std::array<GLsizei, 2> const size{ static_cast<GLsizei>(render_resolution_[0]),
+                                       static_cast<GLsizei>(render_resolution_[1]) };
+    if (size[0] <= 0 || size[1] <= 0)
+        return;
+
+    if (!state.targets[0] || state.target_size != size)
+    {
+        oglbase::Framebuffer::AttachmentDescs const attachments{
+            { GL_COLOR_ATTACHMENT0, GL_RGBA8 }
+        };
+        for (std::unique_ptr<oglbase::Framebuffer> &target : state.targets)
+            target = std::make_unique<oglbase::Framebuffer>(size[0], size[1], attachments, false);
+        state.target_size = size;
+        state.has_completed = false;
+        state.next_tile = 0;
+    }
+
+    if (state.projection != context_.projection_matrix || state.gizmo_generation != gizmo_generation_)
+    {
+        state.projection = context_.projection_matrix;
+        state.gizmo_generation = gizmo_generation_;
+        state.next_tile = 0;
+    }
+
+    int const tile_size = std::max(state.tile_size, 1);
+    int const tile_columns = (size[0] + tile_size - 1) / tile_size;
+    int const tile_rows = (size[1] + tile_size - 1) / tile_size;
+    int const tile_count = tile_columns * tile_rows;
+
+    // Buffer passes run once per progressive pass, every tile of the pass
+    // samples the same channel content.
+    if (state.next_tile == 0)
+    {
+        state.pass_time = _time;
+        RenderBufferPasses(state.pass_time);
+    }
+
+    state.targets[0]->Bind();
+    if (state.next_tile == 0)
+        glClearBufferfv(GL_COLOR, 0, kClearColor);
+
+    BindChannels();
+    KernelProgram &program = ActiveProgram();
+    glUseProgram(program.program);
+    UploadUniforms(program, state.pass_time);
+    glEnable(GL_SCISSOR_TEST);
+
+    // As many tiles as the budget fits at the measured tile cost, one until a
+    // measurement is available. At least one tile is drawn every frame so
+    // that a pass always completes eventually.
+    float const tile_cost = state.tile_timer.elapsed();
+    int const budget_tiles = (tile_cost > 0.f)
+        ? static_cast<int>(std::min(state.frame_budget / tile_cost, static_cast<float>(tile_count)))
+        : 1;
+    int const tiles = std::max(std::min(budget_tiles, tile_count - state.next_tile), 1);
+
+    state.tile_timer.Begin();
+    for (int i = 0; i < tiles; ++i)
+    {
+        glScissor((state.next_tile % tile_columns) * tile_size,
+                  (state.next_tile / tile_columns) * tile_size,
+                  tile_size, tile_size);
+        DrawKernel(program);
+        ++state.next_tile;
+    }
+    state.tile_timer.End(tiles);
+
+    if (state.next_tile >= tile_count)
+    {
+        std::swap(state.targets[0], state.targets[1]);
+        state.has_completed = true;
+        state.next_tile = 0;
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+    glUseProgram(0u);
+}
+
+
+void
+RenderContext::Impl_::PresentTiles(GLuint _target_framebuffer) const
+{
+    ProgressiveState const &state = progressive_;
+    oglbase::Framebuffer const *source = state.targets[state.has_completed ? 1 : 0].get();
+    if (source)
+    {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, source->fbo_);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _target_framebuffer);
+        glBlitFramebuffer(0, 0, state.target_size[0], state.target_size[1],
+                          0, 0, state.target_size[0], state.target_size[1],
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, _target_framebuffer);
+}
+
+
+float
+RenderContext::Impl_::Halton(int _index, int _base)
+{
+    float result = 0.f;
+    float fraction = 1.f;
+    for (int i = _index; i > 0; i /= _base)
+    {
+        fraction /= static_cast<float>(_base);
+        result += fraction * static_cast<float>(i % _base);
+    }
+    return result;
+}
+
+
+void
+RenderContext::Impl_::RenderAccumulated(float _time, GLuint _target_framebuffer)
+{
+    AccumulationState &state = accumulation_;
+    std::array<GLsizei, 2> const size{ static_cast<GLsizei>(render_resolution_[0]),
+                                       static_cast<GLsizei>(render_resolution_[1]) };
+    if (size[0] <= 0 || size[1] <= 0)
+        return;
+
+    if (!state.history || state.target_size != size)
+    {
+        oglbase::Framebuffer::AttachmentDescs const attachments{
+            { GL_COLOR_ATTACHMENT0, GL_RGBA32F }
+        };
+        state.history = std::make_unique<oglbase::Framebuffer>(size[0], size[1], attachments, false);
+        state.target_size = size;
+        state.sample_count = 0;
+    }
+
+    if (state.projection != context_.projection_matrix || state.gizmo_generation != gizmo_generation_)
+    {
+        state.projection = context_.projection_matrix;
+        state.gizmo_generation = gizmo_generation_;
+        state.sample_count = 0;
+    }
+
+    if (state.sample_count < state.max_samples)
+    {
+        if (state.sample_count == 0)
+            state.time = _time;
+
+        if (HasBufferPasses())
+            RenderBufferPasses(state.time);
+
+        // Running average, the first sample overwrites whatever the history
+        // held. Halton(2, 3) offsets spread the samples over the pixel.
+        float const weight = 1.f / static_cast<float>(state.sample_count + 1);
+        Jitter_t const jitter{ Halton(state.sample_count + 1, 2) - 0.5f,
+                               Halton(state.sample_count + 1, 3) - 0.5f };
+
+        state.history->Bind();
+        BindChannels();
+        glEnable(GL_BLEND);
+        glBlendColor(0.f, 0.f, 0.f, weight);
+        glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+
+        KernelProgram &program = ActiveProgram();
+        glUseProgram(program.program);
+        UploadUniforms(program, state.time, jitter);
+        DrawKernel(program);
+        glUseProgram(0u);
+
+        glDisable(GL_BLEND);
+        ++state.sample_count;
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, state.history->fbo_);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _target_framebuffer);
+    glBlitFramebuffer(0, 0, size[0], size[1], 0, 0, size[0], size[1],
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, _target_framebuffer);
+}
+
+
+void
+RenderContext::Impl_::BeginCrossfade(bool _own_passes)
+{
+    Crossfade &state = crossfade_;
+    float const duration = state.pending_duration;
+    state.pending_duration = 0.f;
+    if (duration <= 0.f || !shader_program_.program)
+        return;
+
+    if (!state.blend_program)
+    {
+        if (!buffer_vertex_shader_)
+            buffer_vertex_shader_ = CompileKernel(ShaderStage::kVertex, DefaultKernel(ShaderStage::kVertex)).first;
+        oglbase::ShaderPtr const blend_shader = CompileKernel(ShaderStage::kFragment, { kCrossfadeKernel }).first;
+        if (!blend_shader)
+            return;
+        state.blend_program = oglbase::LinkProgram({ buffer_vertex_shader_, blend_shader });
+    }
+
+    // Progressive and accumulation modes switch right away.
+    if (progressive_.enabled || accumulation_.enabled)
+        return;
+
+    // A crossfade still running is cut short.
+    RetireCrossfadePrograms();
+    state.program = std::move(shader_program_);
+    state.own_passes = _own_passes;
+    state.passes = {};
+    if (_own_passes)
+        std::swap(state.passes, buffer_passes_);
+    state.duration = duration;
+    state.started = false;
+}
+
+
+void
+RenderContext::Impl_::RenderCrossfade(float _time, GLuint _kernel_framebuffer)
+{
+    Crossfade &state = crossfade_;
+    if (!state.started)
+    {
+        state.start_time = _time;
+        state.started = true;
+    }
+
+    float const weight = 1.f - (_time - state.start_time) / state.duration;
+    std::array<GLsizei, 2> const size{ static_cast<GLsizei>(render_resolution_[0]),
+                                       static_cast<GLsizei>(render_resolution_[1]) };
+    if (weight <= 0.f || size[0] <= 0 || size[1] <= 0)
+    {
+        EndCrossfade();
+        return;
+    }
+
+    if (!state.target || state.target_size != size)
+    {
+        oglbase::Framebuffer::AttachmentDescs const attachments{
+            { GL_COLOR_ATTACHMENT0, GL_RGBA8 }
+        };
+        state.target = std::make_unique<oglbase::Framebuffer>(size[0], size[1], attachments, false);
+        state.target_size = size;
+    }
+
+    // The outgoing kernel runs with its own channels.
+    if (state.own_passes)
+        std::swap(state.passes, buffer_passes_);
+    bool const has_buffer_passes = HasBufferPasses();
+    if (has_buffer_passes)
+        RenderBufferPasses(_time);
+
+    state.target->Bind();
+    if (has_buffer_passes)
+        BindChannels();
+    glClearBufferfv(GL_COLOR, 0, kClearColor);
+    glUseProgram(state.program.program);
+    UploadUniforms(state.program, _time);
+    DrawKernel(state.program);
+    if (has_buffer_passes)
+        UnbindChannels();
+    if (state.own_passes)
+        std::swap(state.passes, buffer_passes_);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _kernel_framebuffer);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, state.target->texture(0));
+    glEnable(GL_BLEND);
+    glBlendColor(0.f, 0.f, 0.f, std::min(weight, 1.f));
+    glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    glUseProgram(state.blend_program);
+    glBindVertexArray(dummy_vao_);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0u);
+    glUseProgram(0u);
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0u);
+}
+
+
+void
+RenderContext::Impl_::EndCrossfade()
+{
+    Crossfade &state = crossfade_;
+    RetireCrossfadePrograms();
+    state.program = KernelProgram{};
+    state.passes = {};
+    state.target.reset();
+}
+
+
+void
+RenderContext::Impl_::RetireCrossfadePrograms()
+{
+    Crossfade &state = crossfade_;
+    RetireProgram(state.program);
+    for (std::unique_ptr<BufferPass> &pass : state.passes)
+    {
+        if (pass)
+            RetireProgram(pass->program);
+    }
+}
+
+
+void
+RenderContext::Impl_::UpdateGizmoBuffer()
+{
+    std::vector<Vec3_t> const &positions = context_.gizmo_positions;
+    std::vector<Vec4_t> const &params = context_.gizmo_params;
+    bool const changed = !gizmo_buffer_.buffer() ||
+        positions != uploaded_gizmo_positions_ ||
+        params != uploaded_gizmo_params_;
+
+    if (changed)
+    {
+        static GLint const kOffsetAlignment = [](){
+            GLint result = 1;
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &result);
+            return std::max(result, 1);
+        }();
+
+        // Ranges can't be empty, an empty gizmo list still gets one entry.
+        std::size_t const gizmo_count = positions.size();
+        std::size_t const range_size = std::max<std::size_t>(gizmo_count, 1u) * kGizmoStride;
+        std::size_t const alignment = static_cast<std::size_t>(kOffsetAlignment);
+        std::size_t const params_offset = ((range_size + alignment - 1u) / alignment) * alignment;
+
+        char *data = static_cast<char*>(gizmo_buffer_.Write(params_offset + range_size));
+        std::memset(data, 0, params_offset + range_size);
+        for (std::size_t i = 0; i < gizmo_count; ++i)
+            std::memcpy(data + i * kGizmoStride, positions[i].data(), sizeof(Vec3_t));
+        std::size_t const params_count = std::min(params.size(), gizmo_count);
+        if (params_count)
+            std::memcpy(data + params_offset, params.data(), params_count * sizeof(Vec4_t));
+
+        uploaded_gizmo_positions_ = positions;
+        uploaded_gizmo_params_ = params;
+        gizmo_range_size_ = static_cast<GLsizeiptr>(range_size);
+        gizmo_params_offset_ = static_cast<GLintptr>(params_offset);
+        ++gizmo_generation_;
+    }
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SR_GIZMOS_BINDING, gizmo_buffer_.buffer(),
+                      gizmo_buffer_.offset(), gizmo_range_size_);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SR_GIZMO_PARAMS_BINDING, gizmo_buffer_.buffer(),
+                      gizmo_buffer_.offset() + gizmo_params_offset_, gizmo_range_size_);
+}
+
+
+bool
+RenderContext::Impl_::ReadsIdentifier(std::string const &_source, char const *_identifier)
+{
+    auto const is_identifier = [](char const _c) {
+        return std::isalnum(static_cast<unsigned char>(_c)) || _c == '_';
+    };
+
+    std::size_t position = 0u;
+    while (position < _source.size())
+    {
+        std::size_t next = position + 1u;
+        if (_source.compare(position, 2u, "//") == 0)
+        {
+            next = std::min(_source.find('\n', position), _source.size());
+        }
+        else if (_source.compare(position, 2u, "/*") == 0)
+        {
+            std::size_t const comment_end = _source.find("*/", position + 2u);
+            next = (comment_end == std::string::npos) ? _source.size() : comment_end + 2u;
+        }
+        else if (is_identifier(_source[position]))
+        {
+            next = position;
+            while (next < _source.size() && is_identifier(_source[next]))
+                ++next;
+            if (_source.compare(position, next - position, _identifier) == 0)
+                return true;
+        }
+        position = next;
+    }
+    return false;
+}
+
+
+void
+RenderContext::Impl_::UpdateBuiltinUsage()
+{
+    frame_.reads_time = false;
+    frame_.reads_camera = false;
+    for (ShaderStage stage : active_stages_)
+    {
+        std::string const &source = kernel_sources_[static_cast<std::size_t>(stage)];
+        frame_.reads_time = frame_.reads_time || ReadsIdentifier(source, SR_SL_TIME_UNIFORM);
+        frame_.reads_camera = frame_.reads_camera ||
+            ReadsIdentifier(source, SR_SL_PROJMAT_UNIFORM) ||
+            ReadsIdentifier(source, SR_SL_INV_PROJMAT_UNIFORM) ||
+            ReadsIdentifier(source, SR_SL_PREV_PROJMAT_UNIFORM);
+    }
+}
+
+
+void
+RenderContext::Impl_::BeginFrameUniforms()
+{
+    frame_.region = nullptr;
+    frame_.slot_count = 0u;
+    frame_.rebind = true;
+}
+
+
+void
+RenderContext::Impl_::BindFrameUniforms(float _time, Jitter_t const &_jitter)
+{
+    static std::size_t const kSlotStride = [](){
+        GLint alignment = 1;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        std::size_t const result = static_cast<std::size_t>(std::max(alignment, 1));
+        return ((sizeof(FrameBlock) + result - 1u) / result) * result;
+    }();
+
+    FrameBlock block{};
+    block.projection = context_.projection_matrix;
+    block.inverse_projection = (frame_.bound_offset >= 0 && frame_.bound.projection == block.projection)
+        ? frame_.bound.inverse_projection
+        : InverseMatrix(block.projection);
+    block.previous_projection = temporal_.previous_projection;
+    block.resolution = render_resolution_;
+    block.jitter = _jitter;
+    block.time = _time;
+    block.gizmo_count = static_cast<GLint>(context_.gizmo_positions.size());
+    block.prepass_tile_size = static_cast<float>(depth_prepass_.tile_size);
+
+    bool const unchanged = frame_.bound_offset >= 0 && std::memcmp(&block, &frame_.bound, sizeof(FrameBlock)) == 0;
+    if (unchanged && !frame_.rebind)
+        return;
+
+    if (!unchanged)
+    {
+        // A frame needing more slots fences the region it filled before
+        // moving on.
+        if (frame_.region && frame_.slot_count == kFrameSlotCount)
+        {
+            frame_.buffer.Fence();
+            frame_.region = nullptr;
+        }
+        if (!frame_.region)
+        {
+            frame_.region = static_cast<char*>(frame_.buffer.Write(kFrameSlotCount * kSlotStride));
+            frame_.slot_count = 0u;
+        }
+
+        std::memcpy(frame_.region + frame_.slot_count * kSlotStride, &block, sizeof(FrameBlock));
+        frame_.bound_offset = frame_.buffer.offset() + static_cast<GLintptr>(frame_.slot_count * kSlotStride);
+        frame_.bound = block;
+        ++frame_.slot_count;
+    }
+
+    glBindBufferRange(GL_UNIFORM_BUFFER, SR_FRAME_BINDING, frame_.buffer.buffer(),
+                      frame_.bound_offset, static_cast<GLsizeiptr>(sizeof(FrameBlock)));
+    frame_.rebind = false;
+}
+
+
+void
+RenderContext::Impl_::InstallBufferPasses(std::vector<PendingPass> &_passes)
+{
+    std::array<std::unique_ptr<BufferPass>, kPassCountMax> buffer_passes{};
+    for (PendingPass &pending_pass : _passes)
+    {
+        std::size_t const index = static_cast<std::size_t>(pending_pass.index);
+        if (pending_pass.unchanged)
+        {
+            buffer_passes[index] = std::move(buffer_passes_[index]);
+            continue;
+        }
+
+        std::unique_ptr<BufferPass> pass = std::make_unique<BufferPass>();
+        pass->source = std::move(pending_pass.source);
+        pass->shader_cache[ShaderStage::kFragment] = std::move(pending_pass.shader);
+        pass->target_size = { 0, 0 };
+        SetProgram(pass->program, std::move(pending_pass.program));
+        pass->program.program_key = pending_pass.program_key;
+        buffer_passes[index] = std::move(pass);
+    }
+    for (std::unique_ptr<BufferPass> &pass : buffer_passes_)
+    {
+        if (pass)
+            RetireProgram(pass->program);
+    }
+    buffer_passes_ = std::move(buffer_passes);
+}
+
+
+void
+RenderContext::Impl_::RenderBufferPasses(float _time)
+{
+    std::array<GLsizei, 2> const size{ static_cast<GLsizei>(render_resolution_[0]),
+                                       static_cast<GLsizei>(render_resolution_[1]) };
+    if (size[0] <= 0 || size[1] <= 0)
+        return;
+
+    for (std::size_t index = 0u; index < kPassCountMax; ++index)
+    {
+        BufferPass *pass = buffer_passes_[index].get();
+        bool const prepass = (index == kDepthPrepass);
+        if (!pass || (prepass && !depth_prepass_.enabled))
+            continue;
+
+        GLsizei const tile_size = prepass ? static_cast<GLsizei>(depth_prepass_.tile_size) : 1;
+        std::array<GLsizei, 2> const pass_size{ (size[0] + tile_size - 1) / tile_size,
+                                                (size[1] + tile_size - 1) / tile_size };
+        if (!pass->targets[0] || pass->target_size != pass_size)
+        {
+            GLenum const format = prepass ? GL_R32F : GL_RGBA32F;
+            oglbase::Framebuffer::AttachmentDescs const attachments{
+                { GL_COLOR_ATTACHMENT0, format }
+            };
+            GLint const filter = prepass ? GL_NEAREST : GL_LINEAR;
+            for (std::unique_ptr<oglbase::Framebuffer> &target : pass->targets)
+            {
+                target = std::make_unique<oglbase::Framebuffer>(pass_size[0], pass_size[1], attachments, false);
+                glBindTexture(GL_TEXTURE_2D, target->texture(0));
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glBindTexture(GL_TEXTURE_2D, 0u);
+
+                target->Bind();
+                glClearBufferfv(GL_COLOR, 0, kBufferClearColor);
+            }
+            pass->target_size = pass_size;
+        }
+
+        GLint previous_viewport[4]{};
+        if (prepass)
+        {
+            glGetIntegerv(GL_VIEWPORT, previous_viewport);
+            glViewport(0, 0, pass_size[0], pass_size[1]);
+        }
+
+        pass->targets[0]->Bind();
+        BindChannels();
+        glUseProgram(pass->program.program);
+        UploadUniforms(pass->program, _time);
+        glBindVertexArray(dummy_vao_);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0u);
+
+        if (prepass)
+            glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+        std::swap(pass->targets[0], pass->targets[1]);
+    }
+    glUseProgram(0u);
+}
+
+
+void
+RenderContext::Impl_::BindChannels() const
+{
+    for (std::size_t i = 0; i < kBufferPassCountMax; ++i)
+    {
+        BufferPass const *pass = buffer_passes_[i].get();
+        glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
+        glBindTexture(GL_TEXTURE_2D, (pass && pass->targets[1]) ? pass->targets[1]->texture(0) : 0u);
+    }
+    BufferPass const *prepass = depth_prepass_.enabled ? buffer_passes_[kDepthPrepass].get() : nullptr;
+    glActiveTexture(GL_TEXTURE0 + SR_RAY_START_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, (prepass && prepass->targets[1]) ? prepass->targets[1]->texture(0) : 0u);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+
+void
+RenderContext::Impl_::UnbindChannels() const
+{
+    for (std::size_t i = 0; i < kBufferPassCountMax; ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
+        glBindTexture(GL_TEXTURE_2D, 0u);
+    }
+    glActiveTexture(GL_TEXTURE0 + SR_RAY_START_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, 0u);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+
+bool
+RenderContext::Impl_::HasBufferPasses() const
+{
+    return std::any_of(buffer_passes_.cbegin(), buffer_passes_.cend(),
+                       [](std::unique_ptr<BufferPass> const& _pass) {
+                           return static_cast<bool>(_pass);
+                       });
+}
+
+
+bool
+RenderContext::Impl_::UsesTime() const
+{
+    return frame_.reads_time;
+}
+
+
+bool
+RenderContext::Impl_::NeedsRedraw() const
+{
+    KernelProgram const &program = specialization_.program.program ? specialization_.program : shader_program_;
+    bool const inputs_changed = program.builtins_dirty ||
+        resolution_ != presented_resolution_ ||
+        (frame_.reads_camera && frame_.bound.projection != context_.projection_matrix) ||
+        context_.gizmo_positions != uploaded_gizmo_positions_ ||
+        context_.gizmo_params != uploaded_gizmo_params_ ||
+        std::any_of(program.uniform_bindings.cbegin(), program.uniform_bindings.cend(),
+                    [](UniformBinding const& _binding) {
+                        return _binding.dirty && _binding.location >= 0;
+                    });
+    if (inputs_changed)
+        return true;
+
+    // Accumulation holds iTime, the image is final once every sample is in.
+    if (accumulation_.enabled)
+        return accumulation_.sample_count < accumulation_.max_samples;
+    if (progressive_.enabled && (!progressive_.has_completed || progressive_.next_tile != 0))
+        return true;
+    // Buffer passes read back their previous frame, the depth prepass doesn't.
+    bool const has_feedback = std::any_of(buffer_passes_.cbegin(), buffer_passes_.cbegin() + kBufferPassCountMax,
+                                          [](std::unique_ptr<BufferPass> const& _pass) {
+                                              return static_cast<bool>(_pass);
+                                          });
+    return UsesTime() || has_feedback || crossfade_.program.program;
+}
+
+
+void
+RenderContext::Impl_::UpdateResolutionScale()
+{
+    ResolutionGovernor &governor = governor_;
+    std::size_t const timer_sample = gpu_timer_.sample_count();
+    if (!governor.enabled || timer_sample == governor.timer_sample)
+        return;
+    governor.timer_sample = timer_sample;
+    float const frame_time_sample = gpu_timer_.elapsed();
+    if (timer_sample <= governor.settle_sample || frame_time_sample <= 0.f)
+        return;
+
+    governor.frame_time = (governor.frame_time > 0.f)
+        ? governor.frame_time + (frame_time_sample - governor.frame_time) * kGovernorSmoothing
+        : frame_time_sample;
+
+    float const ratio = governor.target_frame_time / governor.frame_time;
+    if (std::abs(ratio - 1.f) < kGovernorDeadBand)
+        return;
+
+    // Cost is assumed proportional to the pixel count, hence the square root.
+    float const desired_scale = governor.scale * std::sqrt(ratio);
+    float const scale = std::min(1.f, std::max(governor.min_scale,
+        std::round(desired_scale / kGovernorScaleStep) * kGovernorScaleStep));
+    if (scale != governor.scale)
+    {
+        governor.scale = scale;
+        governor.frame_time = governor.target_frame_time;
+        governor.settle_sample = timer_sample + oglbase::GPUTimer::kRingSize;
+    }
+}
+
+
+GLuint
+RenderContext::Impl_::BeginScaledRender(GLuint _target_framebuffer)
+{
+    ResolutionGovernor &governor = governor_;
+    std::array<GLsizei, 2> const size{ static_cast<GLsizei>(resolution_[0]),
+                                       static_cast<GLsizei>(resolution_[1]) };
+    if (!governor.enabled || size[0] <= 0 || size[1] <= 0)
+    {
+        render_resolution_ = resolution_;
+        return _target_framebuffer;
+    }
+
+    if (!governor.target || governor.target_size != size)
+    {
+        oglbase::Framebuffer::AttachmentDescs const attachments{
+            { GL_COLOR_ATTACHMENT0, GL_RGBA8 }
+        };
+        governor.target = std::make_unique<oglbase::Framebuffer>(size[0], size[1], attachments, false);
+        governor.target_size = size;
+    }
+
+    render_resolution_ = { std::max(1.f, std::round(resolution_[0] * governor.scale)),
+                           std::max(1.f, std::round(resolution_[1] * governor.scale)) };
+
+    governor.target->Bind();
+    glViewport(0, 0,
+               static_cast<GLsizei>(render_resolution_[0]),
+               static_cast<GLsizei>(render_resolution_[1]));
+    return governor.target->fbo_;
+}
+
+
+void
+RenderContext::Impl_::EndScaledRender(GLuint _target_framebuffer) const
+{
+    ResolutionGovernor const &governor = governor_;
+    if (!governor.enabled || !governor.target)
+        return;
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, governor.target->fbo_);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _target_framebuffer);
+    glBlitFramebuffer(0, 0,
+                      static_cast<GLint>(render_resolution_[0]),
+                      static_cast<GLint>(render_resolution_[1]),
+                      0, 0, governor.target_size[0], governor.target_size[1],
+                      GL_COLOR_BUFFER_BIT, governor.filter);
+    glBindFramebuffer(GL_FRAMEBUFFER, _target_framebuffer);
+    glViewport(0, 0, governor.target_size[0], governor.target_size[1]);
+}
+
+
+// =============================================================================
+
+RenderContext::RenderContext() :
+    impl_(new RenderContext::Impl_(*this))
+{}
+
+RenderContext::~RenderContext()
+{ delete impl_; }
+
+bool
+RenderContext::RenderFrame()
+{
+    return RenderFrame(impl_->exec_time_.read());
+}
+
+bool
+RenderContext::RenderFrame(float _time)
+{
+    float const elapsed_time = _time;
+    impl_->exec_time_.step();
+    impl_->PollKernelsBuild();
+    impl_->PollPlaylist();
+    impl_->UpdateSpecialization();
+
+    bool start_over = true;
+
+    assert(!oglbase::ClearError());
+
+    glDisable(GL_MULTISAMPLE);
+    glDisable(GL_BLEND);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_STENCIL_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glFrontFace(GL_CCW);
+    glEnable(GL_CULL_FACE);
+
+    impl_->gpu_timer_.Begin();
+    impl_->UpdateResolutionScale();
+    impl_->UpdateGizmoBuffer();
+    impl_->BeginFrameUniforms();
+
+    GLint target_framebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target_framebuffer);
+    GLuint const kernel_framebuffer =
+        impl_->BeginScaledRender(static_cast<GLuint>(target_framebuffer));
+
+    bool const cost_profiled = impl_->ActiveProgram().cost_profiled;
+    if (cost_profiled)
+        impl_->BeginCostFrame();
+    bool const temporal_hits = impl_->ActiveProgram().temporal_hits;
+    if (temporal_hits)
+        impl_->BeginTemporalFrame();
+
+    if (impl_->accumulation_.enabled || impl_->progressive_.enabled)
+        impl_->EndCrossfade();
+
+    if (impl_->accumulation_.enabled)
+    {
+        impl_->RenderAccumulated(elapsed_time, kernel_framebuffer);
+    }
+    else if (impl_->progressive_.enabled)
+    {
+        impl_->RenderTiles(elapsed_time);
+        impl_->PresentTiles(kernel_framebuffer);
+    }
+    else
+    {
+        bool const has_buffer_passes = impl_->HasBufferPasses();
+        if (has_buffer_passes)
+        {
+            impl_->RenderBufferPasses(elapsed_time);
+            glBindFramebuffer(GL_FRAMEBUFFER, kernel_framebuffer);
+            impl_->BindChannels();
+        }
+
+        glClearBufferfv(GL_COLOR, 0, kClearColor);
+
+        Impl_::KernelProgram &program = impl_->ActiveProgram();
+        glUseProgram(program.program);
+        impl_->UploadUniforms(program, elapsed_time);
+        impl_->DrawKernel(program);
+        glUseProgram(0u);
+
+        if (impl_->crossfade_.program.program)
+            impl_->RenderCrossfade(elapsed_time, kernel_framebuffer);
+    }
+
+    if (impl_->HasBufferPasses())
+        impl_->UnbindChannels();
+
+    if (cost_profiled)
+        impl_->RenderCostHeatmap(kernel_framebuffer);
+    if (temporal_hits)
+        impl_->EndTemporalFrame();
+
+    impl_->EndScaledRender(static_cast<GLuint>(target_framebuffer));
+
+    impl_->gizmo_buffer_.Fence();
+    impl_->frame_.buffer.Fence();
+    impl_->gpu_timer_.End();
+    impl_->presented_resolution_ = impl_->resolution_;
+
+    // Submitted right away, a host going idle before its next swap would
+    // otherwise hold the end timestamp back and inflate the GPU frame time.
+    glFlush();
+
+    start_over = start_over && (glGetError() == GL_NO_ERROR);
+    return start_over;
+}
+
+void
+RenderContext::Poll()
+{
+    impl_->kernel_watcher_.Poll();
+    if (!impl_->changed_kernels_.empty())
+        impl_->KernelsUpdate();
+    impl_->PollKernelsBuild();
+    impl_->PollPlaylist();
+    impl_->UpdateSpecialization();
+}
+
+bool
+RenderContext::UsesTime() const
+{
+    return impl_->UsesTime();
+}
+
+bool
+RenderContext::NeedsRedraw() const
+{
+    return impl_->NeedsRedraw();
+}
+
+void
+RenderContext::WatchKernelFile(ShaderStage _stage, char const *_path)
+{
+    if (impl_->active_stages_.count(_stage) != 0)
+    {
+        utility::File kernel_file{ _path };
+        auto const previous_it = impl_->kernel_files_.find(_stage);
+        if (previous_it != impl_->kernel_files_.end())
+        {
+            std::string const previous_path = previous_it->second.path();
+            impl_->kernel_files_.erase(previous_it);
+            bool const path_in_use = std::any_of(
+                impl_->kernel_files_.cbegin(), impl_->kernel_files_.cend(),
+                [&previous_path](std::pair<const ShaderStage, utility::File> const& _kernel_file) {
+                    return _kernel_file.second.path() == previous_path;
+                });
+            if (!path_in_use)
+                impl_->kernel_watcher_.Unwatch(previous_path);
+        }
+
+        impl_->kernel_watcher_.Watch(kernel_file.path());
+        impl_->kernel_files_[_stage] = std::move(kernel_file);
+        impl_->changed_kernels_.insert(_stage);
+        impl_->KernelsUpdate();
+    }
+}
+
+void
+RenderContext::WaitKernelsBuild()
+{
+    impl_->PollKernelsBuild(true);
+}
+
+int
+RenderContext::SetKernelPlaylist(char const *_directory)
+{
+    impl_->playlist_.clear();
+
+    boost::system::error_code error{};
+    boostfs::path const directory{ _directory ? _directory : "" };
+    if (!boostfs::is_directory(directory, error))
+    {
+        std::cout << "Playlist directory not found " << directory.string() << std::endl;
+        return 0;
+    }
+
+    static std::string const kExtension = ".frag.glsl";
+    std::vector<std::string> paths{};
+    for (boostfs::directory_entry const &entry : boostfs::directory_iterator{ directory, error })
+    {
+        std::string const name = entry.path().filename().string();
+        if (boostfs::is_regular_file(entry.path(), error) &&
+            name.size() > kExtension.size() &&
+            name.compare(name.size() - kExtension.size(), kExtension.size(), kExtension) == 0)
+        {
+            paths.push_back(utility::File{ entry.path().generic_string() }.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (std::string &path : paths)
+        impl_->playlist_.push_back(Impl_::PlaylistEntry{ std::move(path), nullptr, false });
+    std::cout << "Playlist of " << impl_->playlist_.size() << " kernel(s)" << std::endl;
+    return static_cast<int>(impl_->playlist_.size());
+}
+
+int
+RenderContext::GetPlaylistSize() const
+{
+    return static_cast<int>(impl_->playlist_.size());
+}
+
+std::string const &
+RenderContext::GetPlaylistKernel(int _index) const
+{
+    static std::string const kNoKernel{};
+    return (_index >= 0 && _index < GetPlaylistSize())
+        ? impl_->playlist_[static_cast<std::size_t>(_index)].path
+        : kNoKernel;
+}
+
+bool
+RenderContext::IsPlaylistKernelReady(int _index) const
+{
+    if (_index < 0 || _index >= GetPlaylistSize())
+        return false;
+    Impl_::PlaylistEntry const &entry = impl_->playlist_[static_cast<std::size_t>(_index)];
+    return entry.build && entry.build->linked;
+}
+
+void
+RenderContext::PlayKernel(int _index, float _crossfade)
+{
+    if (_index < 0 || _index >= GetPlaylistSize())
+        return;
+
+    impl_->crossfade_.pending_duration = _crossfade;
+    WatchKernelFile(ShaderStage::kFragment, impl_->playlist_[static_cast<std::size_t>(_index)].path.c_str());
+}
+
+void
+RenderContext::SetProgressiveRendering(bool _enable, float _frame_budget, int _tile_size)
+{
+    Impl_::ProgressiveState &state = impl_->progressive_;
+    if (!_enable)
+    {
+        state.targets[0].reset();
+        state.targets[1].reset();
+    }
+    else if (_tile_size != state.tile_size)
+    {
+        state.next_tile = 0;
+    }
+    state.enabled = _enable;
+    state.frame_budget = _frame_budget;
+    state.tile_size = _tile_size;
+}
+
+void
+RenderContext::SetComputeExecution(bool _enable, int _workgroup_width, int _workgroup_height,
+                                   ComputeTileOrder _tile_order)
+{
+    Impl_::ComputeExecution &state = impl_->compute_;
+    std::array<int, 2> const workgroup_size{ std::max(_workgroup_width, 1), std::max(_workgroup_height, 1) };
+    bool const mode_changed = (state.enabled != _enable) ||
+        (_enable && (state.workgroup_size != workgroup_size || state.tile_order != _tile_order));
+    state.enabled = _enable;
+    state.workgroup_size = workgroup_size;
+    state.tile_order = _tile_order;
+    if (!mode_changed)
+        return;
+
+    impl_->active_stages_ = _enable
+        ? std::set<ShaderStage>{ ShaderStage::kFragment }
+        : std::set<ShaderStage>{ ShaderStage::kVertex, ShaderStage::kFragment };
+    impl_->OnExecutionModeChanged();
+}
+
+void
+RenderContext::SetCostProfiling(bool _enable, float _heatmap_opacity)
+{
+    Impl_::CostProfiling &state = impl_->cost_;
+    state.heatmap_opacity = _heatmap_opacity;
+    if (state.enabled == _enable)
+        return;
+
+    state.enabled = _enable;
+    state.pending = false;
+    state.readback.Reset();
+    state.stats = CostStats{ 0u, 0u, 0.f, SR_COST_TILE_SIZE, {} };
+    impl_->OnExecutionModeChanged();
+}
+
+CostStats const &
+RenderContext::GetCostStats() const
+{
+    return impl_->cost_.stats;
+}
+
+void
+RenderContext::SetDepthPrepass(bool _enable, int _tile_size)
+{
+    Impl_::DepthPrepass &state = impl_->depth_prepass_;
+    int const tile_size = std::max(_tile_size, 1);
+    if (state.enabled == _enable && state.tile_size == tile_size)
+        return;
+
+    state.enabled = _enable;
+    state.tile_size = tile_size;
+    impl_->ForEachProgram([](Impl_::KernelProgram &_program) {
+        _program.builtins_dirty = true;
+    });
+}
+
+void
+RenderContext::SetTemporalRayReuse(bool _enable)
+{
+    Impl_::TemporalHits &state = impl_->temporal_;
+    if (state.enabled == _enable)
+        return;
+
+    state.enabled = _enable;
+    state.hits = { oglbase::TexturePtr{ 0u }, oglbase::TexturePtr{ 0u } };
+    state.size = { 0, 0 };
+    impl_->OnExecutionModeChanged();
+}
+
+void
+RenderContext::SetAccumulation(bool _enable, int _max_samples)
+{
+    Impl_::AccumulationState &state = impl_->accumulation_;
+    if (!_enable)
+        state.history.reset();
+    state.enabled = _enable;
+    state.max_samples = std::max(_max_samples, 1);
+}
+
+int
+RenderContext::GetAccumulatedSamples() const
+{
+    Impl_::AccumulationState const &state = impl_->accumulation_;
+    return state.enabled ? state.sample_count : 0;
+}
+
+void
+RenderContext::SetUniformFreezing(bool _enable, float _idle_delay)
+{
+    Impl_::Specialization &state = impl_->specialization_;
+    if (!_enable)
+        impl_->ResetSpecialization();
+    state.enabled = _enable;
+    state.delay = std::max(_idle_delay, 0.f);
+}
+
+int
+RenderContext::GetFrozenUniformCount() const
+{
+    return static_cast<int>(impl_->specialization_.frozen.size());
+}
+
+void
+RenderContext::SetResolutionGovernor(bool _enable, float _target_frame_time,
+                                     GLenum _filter, float _min_scale)
+{
+    Impl_::ResolutionGovernor &governor = impl_->governor_;
+    if (!_enable)
+    {
+        governor.target.reset();
+        governor.scale = 1.f;
+    }
+    governor.enabled = _enable;
+    governor.target_frame_time = _target_frame_time;
+    governor.filter = _filter;
+    governor.min_scale = std::min(1.f, std::max(_min_scale, Impl_::kGovernorScaleStep));
+    governor.scale = std::max(governor.scale, governor.min_scale);
+    governor.frame_time = 0.f;
+}
+
+float
+RenderContext::GetResolutionScale() const
+{
+    return impl_->governor_.enabled ? impl_->governor_.scale : 1.f;
+}
+
+float
+RenderContext::GetGPUFrameTime() const
+{
+    return impl_->gpu_timer_.elapsed();
+}
+
+void
+RenderContext::AddKernelIncludePath(char const *_path)
+{
+    impl_->kernel_preprocessor_.AddSearchPath(_path);
+    for (auto &&kernel_file : impl_->kernel_files_)
+        impl_->changed_kernels_.insert(kernel_file.first);
+}
+
+void
+RenderContext::SetKernelReloadDebounce(float _seconds)
+{
+    impl_->kernel_watcher_.SetDebounce(_seconds);
+}
+
+void
+RenderContext::SetShaderMemoryBudget(std::size_t _bytes)
+{
+    impl_->shader_cache_.SetMemoryBudget(_bytes);
+}
+
+void
+RenderContext::SetResolution(int _width, int _height)
+{
+    impl_->resolution_ = { boost::numeric_cast<float>(_width),
+                           boost::numeric_cast<float>(_height) };
+    glViewport(0, 0, _width, _height);
+}
+
+
+void
+RenderContext::SetUniforms(UniformStore const&_uniforms)
+{
+    UniformStore &uniforms = impl_->uniforms_;
+    if (!_uniforms.SameLayout(uniforms))
+    {
+        uniforms = _uniforms;
+        impl_->ResetSpecialization();
+        impl_->progressive_.next_tile = 0;
+        impl_->accumulation_.sample_count = 0;
+        impl_->ForEachProgram([this](Impl_::KernelProgram &_program) {
+            impl_->BindUniforms(_program);
+        });
+        return;
+    }
+
+    for (std::size_t i = 0; i < uniforms.size(); ++i)
+        impl_->SetUniformValue(i, _uniforms.data(i));
+}
+
+int
+RenderContext::ResolveUniform(char const *_name, UniformType _type)
+{
+    UniformStore const &uniforms = impl_->uniforms_;
+    int const handle = uniforms.Find(_name);
+    if (handle >= 0 && uniforms[static_cast<std::size_t>(handle)].type == _type)
+        return handle;
+
+    UniformStore extended_uniforms = uniforms;
+    int const extended_handle = extended_uniforms.Add(_name, _type);
+    SetUniforms(extended_uniforms);
+    return extended_handle;
+}
+
+void
+RenderContext::SetUniformValue(int _handle, float _value)
+{
+    if (_handle >= 0 && static_cast<std::size_t>(_handle) < impl_->uniforms_.size() &&
+        impl_->uniforms_[static_cast<std::size_t>(_handle)].type == UniformType::kFloat)
+        impl_->SetUniformValue(static_cast<std::size_t>(_handle), &_value);
+}
+
+void
+RenderContext::SetUniformData(int _handle, void const *_data)
+{
+    if (_handle >= 0)
+        impl_->SetUniformValue(static_cast<std::size_t>(_handle), _data);
+}
+
+int
+RenderContext::RenderFrames(float const *_times, int _count, void *o_pixels,
+                            std::function<void(int)> const &_prepare)
+{
+    if (!_times || _count <= 0)
+        return 0;
+
+    GLint previous_framebuffer = 0;
+    GLint previous_viewport[4]{};
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous_framebuffer);
+    glGetIntegerv(GL_VIEWPORT, previous_viewport);
+
+    // The first frame may change the resolution, the batch keeps the one it
+    // starts with.
+    if (_prepare)
+        _prepare(0);
+    std::array<GLsizei, 2> const size{ static_cast<GLsizei>(impl_->resolution_[0]),
+                                       static_cast<GLsizei>(impl_->resolution_[1]) };
+    if (size[0] <= 0 || size[1] <= 0)
+        return 0;
+    impl_->ResizeOffscreenTarget(size);
+
+    Impl_::OffscreenTarget const &target = impl_->offscreen_;
+    std::size_t const frame_size = static_cast<std::size_t>(size[0]) * size[1] * 4u;
+    // A frame that can't be mapped ends the batch, o_pixels only holds the
+    // frames copied before it.
+    auto const copy_frame = [&target, frame_size, o_pixels](int _frame_index) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER,
+                     target.readback_buffers[static_cast<std::size_t>(_frame_index) % Impl_::kReadbackLatency]);
+        void const *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                              static_cast<GLsizeiptr>(frame_size), GL_MAP_READ_BIT);
+        if (!pixels)
+            return false;
+        std::memcpy(static_cast<std::uint8_t*>(o_pixels) + frame_size * static_cast<std::size_t>(_frame_index),
+                    pixels, frame_size);
+        return glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+    };
+
+    int frame_index = 0;
+    int copied_count = 0;
+    bool copy_failed = false;
+    for (; frame_index < _count; ++frame_index)
+    {
+        if (_prepare && frame_index > 0)
+            _prepare(frame_index);
+
+        target.framebuffer->Bind();
+        glViewport(0, 0, size[0], size[1]);
+        if (!RenderFrame(_times[frame_index]))
+            break;
+
+        if (o_pixels)
+        {
+            if (frame_index >= static_cast<int>(Impl_::kReadbackLatency))
+            {
+                copy_failed = !copy_frame(frame_index - static_cast<int>(Impl_::kReadbackLatency));
+                if (copy_failed)
+                    break;
+                ++copied_count;
+            }
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, target.framebuffer->fbo_);
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER,
+                         target.readback_buffers[static_cast<std::size_t>(frame_index) % Impl_::kReadbackLatency]);
+            glReadPixels(0, 0, size[0], size[1], GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+
+    if (o_pixels)
+    {
+        for (; !copy_failed && copied_count < frame_index; ++copied_count)
+            copy_failed = !copy_frame(copied_count);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0u);
+        if (copy_failed)
+            std::cout << "Frame readback failed after " << copied_count << " frame(s)" << std::endl;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous_framebuffer));
+    glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2], previous_viewport[3]);
+    return o_pixels ? copied_count : frame_index;
+}
+
+UniformStore const&
+RenderContext::GetUniforms() const
+{
+    return impl_->uniforms_;
+}
+
+std::string const &
+RenderContext::GetKernelPath(ShaderStage _stage) const
+{
+    auto const kernel_file_it = impl_->kernel_files_.find(_stage);
+    if (kernel_file_it != std::end(impl_->kernel_files_))
+        return kernel_file_it->second.path();
+    else
+    {
+        static std::string const empty{ "" };
+        return empty;
+    }
+}
+
+
+} //namespace sr
+
+static void
+ApplyFrameDesc(sr::RenderContext &_context, FrameDesc const &_desc, bool _apply_resolution)
+{
+    if (_apply_resolution && _desc.res[0] >= 1.f && _desc.res[1] >= 1.f)
+        _context.SetResolution(static_cast<int>(_desc.res[0]), static_cast<int>(_desc.res[1]));
+
+    if (_desc.uvalues)
+    {
+        std::uint32_t const *value = static_cast<std::uint32_t const*>(_desc.uvalues);
+        for (int i = 0; i < _desc.ucount; ++i)
+        {
+            // The values past an unknown type can't be located.
+            if (_desc.utypes && _desc.utypes[i] >= static_cast<std::uint32_t>(sr::UniformType::kCount))
+                break;
+            sr::UniformType const type = _desc.utypes
+                ? static_cast<sr::UniformType>(_desc.utypes[i])
+                : sr::UniformType::kFloat;
+            int const handle = _desc.unames ? _context.ResolveUniform(_desc.unames[i], type)
+                             : _desc.uhandles ? _desc.uhandles[i]
+                             : i;
+            sr::UniformStore const &uniforms = _context.GetUniforms();
+            if (handle >= 0 && static_cast<std::size_t>(handle) < uniforms.size() &&
+                uniforms[static_cast<std::size_t>(handle)].type == type)
+                _context.SetUniformData(handle, value);
+            value += sr::UniformComponentCount(type);
+        }
+    }
+
+    std::copy(std::cbegin(_desc.projection_matrix), std::cend(_desc.projection_matrix),
+              _context.projection_matrix.begin());
+
+    std::size_t const gizmo_count = (_desc.gizmo_positions && _desc.gizmo_count > 0)
+        ? static_cast<std::size_t>(_desc.gizmo_count)
+        : 0u;
+    _context.gizmo_positions.resize(gizmo_count);
+    if (gizmo_count)
+        std::memcpy(_context.gizmo_positions.data(), _desc.gizmo_positions, gizmo_count * sizeof(sr::Vec3_t));
+    _context.gizmo_params.resize(_desc.gizmo_params ? gizmo_count : 0u);
+    if (_desc.gizmo_params && gizmo_count)
+        std::memcpy(_context.gizmo_params.data(), _desc.gizmo_params, gizmo_count * sizeof(sr::Vec4_t));
+}
+
+extern "C"
 {
 
     void* srCreateContext()
@@ -541,7 +3925,70 @@ extern "C"
 
     bool srRenderFrame(void* context, FrameDesc const* desc)
     {
-        return ((sr::RenderContext*)context)->RenderFrame();
+        sr::RenderContext &render_context = *(sr::RenderContext*)context;
+        if (desc)
+            ApplyFrameDesc(render_context, *desc, true);
+        return render_context.RenderFrame();
+    }
+
+    int srRenderFrames(void* context, FrameDesc const* descs, float const* times, int count, void* pixels)
+    {
+        sr::RenderContext &render_context = *(sr::RenderContext*)context;
+        return render_context.RenderFrames(times, count, pixels,
+                                           [&render_context, descs](int _frame_index) {
+                                               if (descs)
+                                                   ApplyFrameDesc(render_context, descs[_frame_index],
+                                                                  _frame_index == 0);
+                                           });
+    }
+
+    int srResolveUniform(void* context, char const* name)
+    {
+        return ((sr::RenderContext*)context)->ResolveUniform(name);
+    }
+
+    int srResolveTypedUniform(void* context, char const* name, std::uint32_t type)
+    {
+        if (type >= static_cast<std::uint32_t>(sr::UniformType::kCount))
+            return -1;
+        return ((sr::RenderContext*)context)->ResolveUniform(name, (sr::UniformType)type);
+    }
+
+    void srSetUniformValue(void* context, int handle, float value)
+    {
+        ((sr::RenderContext*)context)->SetUniformValue(handle, value);
+    }
+
+    void srSetUniformData(void* context, int handle, void const* data)
+    {
+        ((sr::RenderContext*)context)->SetUniformData(handle, data);
+    }
+
+    int srGetUniforms(void* context, char const** names, std::uint32_t* types, void const** values, int capacity)
+    {
+        sr::UniformStore const &uniforms = ((sr::RenderContext*)context)->GetUniforms();
+        int const count = static_cast<int>(uniforms.size());
+        for (int i = 0; i < std::min(count, capacity); ++i)
+        {
+            std::size_t const index = static_cast<std::size_t>(i);
+            if (names)
+                names[i] = uniforms[index].name.c_str();
+            if (types)
+                types[i] = static_cast<std::uint32_t>(uniforms[index].type);
+            if (values)
+                values[i] = uniforms.data(index);
+        }
+        return count;
+    }
+
+    void srSetResolution(void* context, int width, int height)
+    {
+        ((sr::RenderContext*)context)->SetResolution(width, height);
+    }
+
+    void srWaitKernelsBuild(void* context)
+    {
+        ((sr::RenderContext*)context)->WaitKernelsBuild();
     }
 
     void srWatchKernelFile(void* context, std::uint32_t stage, char const* path)
@@ -554,5 +4001,10 @@ extern "C"
         return ((sr::RenderContext*)context)->GetKernelPath((sr::ShaderStage)stage).c_str();
     }
 
+    float srGetGPUFrameTime(void* context)
+    {
+        return ((sr::RenderContext*)context)->GetGPUFrameTime();
+    }
+
 }
 
@@ -0,0 +1,188 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "shaderunner/uniform_store.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace sr {
+
+
+static_assert(sizeof(float) == sizeof(std::uint32_t) && sizeof(GLint) == sizeof(std::uint32_t),
+              "Uniform components are 4 bytes");
+
+
+std::size_t
+UniformComponentCount(UniformType _type)
+{
+	switch (_type)
+	{
+	case UniformType::kVec2: case UniformType::kIVec2: return 2u;
+	case UniformType::kVec3: case UniformType::kIVec3: return 3u;
+	case UniformType::kVec4: case UniformType::kIVec4: return 4u;
+	case UniformType::kMat3: return 9u;
+	case UniformType::kMat4: return 16u;
+	default: return 1u;
+	}
+}
+
+bool
+IsIntegerUniform(UniformType _type)
+{
+	return _type == UniformType::kInt || _type == UniformType::kIVec2 ||
+		_type == UniformType::kIVec3 || _type == UniformType::kIVec4 ||
+		_type == UniformType::kBool;
+}
+
+char const *
+UniformTypeName(UniformType _type)
+{
+	switch (_type)
+	{
+	case UniformType::kVec2: return "vec2";
+	case UniformType::kVec3: return "vec3";
+	case UniformType::kVec4: return "vec4";
+	case UniformType::kInt: return "int";
+	case UniformType::kIVec2: return "ivec2";
+	case UniformType::kIVec3: return "ivec3";
+	case UniformType::kIVec4: return "ivec4";
+	case UniformType::kBool: return "bool";
+	case UniformType::kMat3: return "mat3";
+	case UniformType::kMat4: return "mat4";
+	default: return "float";
+	}
+}
+
+GLenum
+UniformTypeToGLenum(UniformType _type)
+{
+	switch (_type)
+	{
+	case UniformType::kVec2: return GL_FLOAT_VEC2;
+	case UniformType::kVec3: return GL_FLOAT_VEC3;
+	case UniformType::kVec4: return GL_FLOAT_VEC4;
+	case UniformType::kInt: return GL_INT;
+	case UniformType::kIVec2: return GL_INT_VEC2;
+	case UniformType::kIVec3: return GL_INT_VEC3;
+	case UniformType::kIVec4: return GL_INT_VEC4;
+	case UniformType::kBool: return GL_BOOL;
+	case UniformType::kMat3: return GL_FLOAT_MAT3;
+	case UniformType::kMat4: return GL_FLOAT_MAT4;
+	default: return GL_FLOAT;
+	}
+}
+
+
+int
+UniformStore::Add(std::string const &_name, UniformType _type)
+{
+	auto const index_it = index_.find(_name);
+	if (index_it != index_.cend())
+	{
+		if (uniforms_[index_it->second].type != _type)
+			Retype(index_it->second, _type);
+		return static_cast<int>(index_it->second);
+	}
+
+	uniforms_.push_back(Uniform{ _name, _type, blob_.size() });
+	blob_.resize(blob_.size() + UniformComponentCount(_type), 0u);
+	index_.emplace(_name, uniforms_.size() - 1u);
+	return static_cast<int>(uniforms_.size() - 1u);
+}
+
+int
+UniformStore::Find(std::string const &_name) const
+{
+	auto const index_it = index_.find(_name);
+	return (index_it != index_.cend()) ? static_cast<int>(index_it->second) : -1;
+}
+
+void
+UniformStore::Rename(std::size_t _index, std::string const &_name)
+{
+	assert(_index < uniforms_.size());
+	Uniform &uniform = uniforms_[_index];
+	if (uniform.name == _name)
+		return;
+
+	auto const index_it = index_.find(uniform.name);
+	if (index_it != index_.cend() && index_it->second == _index)
+	{
+		index_.erase(index_it);
+		// A duplicate of the previous name takes over.
+		for (std::size_t i = 0; i < uniforms_.size(); ++i)
+		{
+			if (i != _index && uniforms_[i].name == uniform.name)
+			{
+				index_.emplace(uniform.name, i);
+				break;
+			}
+		}
+	}
+
+	uniform.name = _name;
+	auto const new_index_it = index_.find(_name);
+	if (new_index_it == index_.cend() || new_index_it->second > _index)
+		index_[_name] = _index;
+}
+
+bool
+UniformStore::Set(std::size_t _index, void const *_data)
+{
+	assert(_index < uniforms_.size());
+	std::size_t const size = UniformComponentCount(uniforms_[_index].type) * sizeof(std::uint32_t);
+	void* const value = data(_index);
+	if (std::memcmp(value, _data, size) == 0)
+		return false;
+	std::memcpy(value, _data, size);
+	return true;
+}
+
+void*
+UniformStore::data(std::size_t _index)
+{
+	assert(_index < uniforms_.size());
+	return blob_.data() + uniforms_[_index].offset;
+}
+
+void const*
+UniformStore::data(std::size_t _index) const
+{
+	assert(_index < uniforms_.size());
+	return blob_.data() + uniforms_[_index].offset;
+}
+
+bool
+UniformStore::SameLayout(UniformStore const &_other) const
+{
+	return std::equal(uniforms_.cbegin(), uniforms_.cend(), _other.uniforms_.cbegin(), _other.uniforms_.cend(),
+					  [](Uniform const& _lhs, Uniform const& _rhs) {
+						  return _lhs.name == _rhs.name && _lhs.type == _rhs.type;
+					  });
+}
+
+void
+UniformStore::Retype(std::size_t _index, UniformType _type)
+{
+	Uniform &uniform = uniforms_[_index];
+	std::size_t const previous_count = UniformComponentCount(uniform.type);
+	std::size_t const count = UniformComponentCount(_type);
+	auto const value_it = blob_.begin() + static_cast<std::ptrdiff_t>(uniform.offset);
+
+	blob_.erase(value_it, value_it + static_cast<std::ptrdiff_t>(previous_count));
+	blob_.insert(blob_.begin() + static_cast<std::ptrdiff_t>(uniform.offset), count, 0u);
+	uniform.type = _type;
+	for (std::size_t i = _index + 1u; i < uniforms_.size(); ++i)
+		uniforms_[i].offset = uniforms_[i].offset - previous_count + count;
+}
+
+
+} // namespace sr
@@ -35,7 +35,7 @@ File::ReadAll()
 {
 	assert(Exists());
 	std::stringstream string_stream{};
-	std::fstream file_stream{ path_ };
+	std::ifstream file_stream{ path_ };
 	file_stream >> string_stream.rdbuf();
 	read_time_ = std::time(nullptr);
 	return string_stream.str();
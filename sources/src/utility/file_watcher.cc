@@ -0,0 +1,231 @@
+/*
+ * ----------------------------------------------------------------------------
+ * "THE BEER-WARE LICENSE" (Revision 42):
+ * Samuel Bourasseau wrote this file. As long as you retain this notice you
+ * can do whatever you want with this stuff. If we meet some day, and you think
+ * this stuff is worth it, you can buy me a beer in return.
+ * ----------------------------------------------------------------------------
+ */
+
+#include "utility/file_watcher.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace utility {
+
+namespace boostfs = ::boost::filesystem;
+
+struct FileWatcher::Impl_
+{
+	using StdClock_t = std::chrono::steady_clock;
+
+	explicit Impl_(float _debounce);
+	~Impl_();
+
+	void Touch(std::string const &_path);
+	void ReadEvents();
+
+	std::chrono::duration<float> debounce_;
+
+	// Watched path -> last known write time, only used by the polling fallback.
+	std::unordered_map<std::string, std::time_t> files_;
+	// Path -> time of the most recent event, reported once the debounce expires.
+	std::unordered_map<std::string, StdClock_t::time_point> pending_;
+
+#ifdef __linux__
+	int inotify_fd_;
+	// Directory -> inotify watch, directories are shared between files.
+	std::unordered_map<std::string, int> directory_watches_;
+	std::unordered_map<int, std::string> watched_directories_;
+#else
+	static constexpr float kPollPeriod = 0.25f;
+	StdClock_t::time_point last_poll_;
+#endif
+};
+
+
+FileWatcher::Impl_::Impl_(float _debounce) :
+	debounce_{ _debounce },
+	files_{},
+	pending_{}
+#ifdef __linux__
+	,inotify_fd_{ inotify_init1(IN_NONBLOCK | IN_CLOEXEC) },
+	directory_watches_{},
+	watched_directories_{}
+#else
+	,last_poll_{ StdClock_t::now() }
+#endif
+{
+#ifdef __linux__
+	if (inotify_fd_ < 0)
+		std::cout << "inotify unavailable, file changes won't be reported" << std::endl;
+#endif
+}
+
+FileWatcher::Impl_::~Impl_()
+{
+#ifdef __linux__
+	if (inotify_fd_ >= 0)
+		close(inotify_fd_);
+#endif
+}
+
+void
+FileWatcher::Impl_::Touch(std::string const &_path)
+{
+	pending_[_path] = StdClock_t::now();
+}
+
+void
+FileWatcher::Impl_::ReadEvents()
+{
+#ifdef __linux__
+	if (inotify_fd_ < 0)
+		return;
+
+	alignas(inotify_event) std::array<char, 4096> buffer;
+	for (;;)
+	{
+		ssize_t const length = read(inotify_fd_, buffer.data(), buffer.size());
+		if (length <= 0)
+			break;
+
+		for (char const *it = buffer.data(); it < buffer.data() + length;)
+		{
+			inotify_event const &event = *reinterpret_cast<inotify_event const*>(it);
+			it += sizeof(inotify_event) + event.len;
+
+			auto const directory_it = watched_directories_.find(event.wd);
+			if (directory_it == watched_directories_.end() || event.len == 0)
+				continue;
+
+			std::string const path =
+				(boostfs::path{ directory_it->second } / std::string{ event.name }).generic_string();
+			if (files_.count(path))
+				Touch(path);
+		}
+	}
+#else
+	StdClock_t::time_point const now = StdClock_t::now();
+	if (std::chrono::duration<float>(now - last_poll_).count() < kPollPeriod)
+		return;
+	last_poll_ = now;
+
+	for (auto &&file : files_)
+	{
+		boost::system::error_code error{};
+		std::time_t const write_time = boostfs::last_write_time(boostfs::path{ file.first }, error);
+		if (!error && write_time != file.second)
+		{
+			file.second = write_time;
+			Touch(file.first);
+		}
+	}
+#endif
+}
+
+// =============================================================================
+
+FileWatcher::FileWatcher(float _debounce) :
+	impl_{ new Impl_(_debounce) }
+{}
+
+FileWatcher::~FileWatcher()
+{ delete impl_; }
+
+void
+FileWatcher::Watch(std::string const &_path)
+{
+	if (impl_->files_.count(_path))
+		return;
+
+	boost::system::error_code error{};
+	impl_->files_[_path] = boostfs::last_write_time(boostfs::path{ _path }, error);
+
+#ifdef __linux__
+	if (impl_->inotify_fd_ < 0)
+		return;
+
+	std::string const directory = boostfs::path{ _path }.parent_path().generic_string();
+	if (impl_->directory_watches_.count(directory))
+		return;
+
+	static constexpr std::uint32_t kEventMask =
+		IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_ATTRIB;
+	int const watch = inotify_add_watch(impl_->inotify_fd_, directory.c_str(), kEventMask);
+	if (watch < 0)
+	{
+		std::cout << "Failed to watch directory " << directory << std::endl;
+		return;
+	}
+	impl_->directory_watches_[directory] = watch;
+	impl_->watched_directories_[watch] = directory;
+#endif
+}
+
+void
+FileWatcher::Unwatch(std::string const &_path)
+{
+	impl_->files_.erase(_path);
+	impl_->pending_.erase(_path);
+
+#ifdef __linux__
+	std::string const directory = boostfs::path{ _path }.parent_path().generic_string();
+	bool const directory_in_use = std::any_of(
+		impl_->files_.cbegin(), impl_->files_.cend(),
+		[&directory](std::pair<const std::string, std::time_t> const& _file) {
+			return boostfs::path{ _file.first }.parent_path().generic_string() == directory;
+		});
+
+	auto const watch_it = impl_->directory_watches_.find(directory);
+	if (!directory_in_use && watch_it != impl_->directory_watches_.end())
+	{
+		inotify_rm_watch(impl_->inotify_fd_, watch_it->second);
+		impl_->watched_directories_.erase(watch_it->second);
+		impl_->directory_watches_.erase(watch_it);
+	}
+#endif
+}
+
+void
+FileWatcher::SetDebounce(float _debounce)
+{
+	impl_->debounce_ = std::chrono::duration<float>{ _debounce };
+}
+
+void
+FileWatcher::Poll()
+{
+	impl_->ReadEvents();
+
+	Impl_::StdClock_t::time_point const now = Impl_::StdClock_t::now();
+	std::vector<std::string> settled_paths{};
+	for (auto &&pending : impl_->pending_)
+	{
+		if (now - pending.second >= impl_->debounce_)
+			settled_paths.push_back(pending.first);
+	}
+
+	for (std::string const &path : settled_paths)
+	{
+		impl_->pending_.erase(path);
+		onFileChanged(path);
+	}
+}
+
+
+} // namespace utility
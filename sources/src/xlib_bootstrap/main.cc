@@ -13,6 +13,8 @@
 #include <chrono>
 #include <cstring>
 
+#include <sys/select.h>
+
 #include <X11/extensions/Xfixes.h>
 #include <X11/Xlib.h>
 #include <X11/Xos.h>
@@ -86,10 +88,33 @@ struct ApplicationHandles
 static constexpr int boot_width = 1280;
 static constexpr int boot_height = 720;
 
+// Rendering on demand, kernel files are polled at this interval while idle.
+// Frames keep coming for a moment after an event so that imgui settles.
+static constexpr std::chrono::milliseconds kIdlePollInterval{ 100 };
+static constexpr std::chrono::milliseconds kEventRedrawDuration{ 250 };
+
+// Blocks until the X connection has something to read or _timeout elapsed.
+static void WaitForEvents(Display* _display, std::chrono::milliseconds _timeout)
+{
+    int const fd = ConnectionNumber(_display);
+    fd_set read_fds;
+    FD_ZERO(&read_fds);
+    FD_SET(fd, &read_fds);
+    timeval timeout{ 0, static_cast<suseconds_t>(_timeout.count() * 1000) };
+    select(fd + 1, &read_fds, nullptr, nullptr, &timeout);
+}
+
 std::unique_ptr<appbase::LayerMediator> layer_mediator;
 
 int main(int __argc, char* __argv[])
 {
+    // Optional leading "--playlist", prewarms the kernels next to the
+    // fragment kernel for instant switching. Off by default, every kernel of
+    // the directory is built in the background and stays resident.
+    bool const load_playlist = (__argc > 1 && std::strcmp(__argv[1], "--playlist") == 0);
+    int const arg_count = load_playlist ? __argc - 1 : __argc;
+    char** const args = load_playlist ? __argv + 1 : __argv;
+
     Display * const display = XOpenDisplay(nullptr);
     if (!display)
     {
@@ -179,6 +204,7 @@ int main(int __argc, char* __argv[])
 
     static constexpr long kEventMask =
         StructureNotifyMask
+        | ExposureMask | VisibilityChangeMask
         | ButtonPressMask | ButtonReleaseMask
         | PointerMotionMask
         | KeyPressMask | KeyReleaseMask;
@@ -270,17 +296,26 @@ int main(int __argc, char* __argv[])
     layer_mediator->SpecialKey(appbase::eKey::kEnter, (std::uint8_t)(XK_Return & 0xff));
     layer_mediator->SpecialKey(appbase::eKey::kEscape, (std::uint8_t)(XK_Escape & 0xff));
 
-    if (__argc > 1)
+    if (arg_count > 1)
+    {
+        layer_mediator->sr_layer_->WatchKernelFile(sr::ShaderStage::kFragment, args[1]);
+    }
+    if (arg_count > 1 && load_playlist)
     {
-        layer_mediator->sr_layer_->WatchKernelFile(sr::ShaderStage::kFragment, __argv[1]);
+        std::string const kernel_path{ args[1] };
+        std::size_t const separator = kernel_path.find_last_of("/\\");
+        std::string const kernel_directory = (separator == std::string::npos)
+            ? std::string{ "." }
+            : kernel_path.substr(0u, separator);
+        layer_mediator->sr_layer_->SetKernelPlaylist(kernel_directory.c_str());
     }
-    if (__argc > 3)
+    if (arg_count > 3)
     {
-        layer_mediator->sr_layer_->WatchKernelFile(sr::ShaderStage::kVertex, __argv[3]);
+        layer_mediator->sr_layer_->WatchKernelFile(sr::ShaderStage::kVertex, args[3]);
     }
-    if (__argc > 2)
+    if (arg_count > 2)
     {
-        layer_mediator->sr_layer_->WatchKernelFile(sr::ShaderStage::kGeometry, __argv[2]);
+        layer_mediator->sr_layer_->WatchKernelFile(sr::ShaderStage::kGeometry, args[2]);
     }
 
 
@@ -293,15 +328,43 @@ int main(int __argc, char* __argv[])
     float frame_time = 0.f;
     float last_frame_time = 0.f;
     bool hide_cursor = false;
+    bool visible = true;
+    StdClock::time_point redraw_until = StdClock::now() + kEventRedrawDuration;
     for(bool run = true; run;)
     {
+        if (!XPending(display))
+        {
+            bool const frame_needed = visible &&
+                (StdClock::now() < redraw_until || layer_mediator->NeedsFrame());
+            if (!frame_needed)
+            {
+                if (layer_mediator->sr_layer_)
+                    layer_mediator->sr_layer_->Poll();
+                if (!visible || !layer_mediator->NeedsFrame())
+                    WaitForEvents(display, kIdlePollInterval);
+                continue;
+            }
+        }
+
         auto start = StdClock::now();
 
         XEvent xevent;
         while (XCheckWindowEvent(display, window, kEventMask, &xevent))
         {
+            redraw_until = StdClock::now() + kEventRedrawDuration;
             switch(xevent.type)
             {
+            case MapNotify:
+            case UnmapNotify:
+            {
+                visible = (xevent.type == MapNotify);
+            } break;
+
+            case VisibilityNotify:
+            {
+                visible = (xevent.xvisibility.state != VisibilityFullyObscured);
+            } break;
+
             case ConfigureNotify:
             {
                 XConfigureEvent const& xcevent = xevent.xconfigure;
@@ -382,9 +445,15 @@ int main(int __argc, char* __argv[])
             run = !(xevent.xclient.data.l[0] == wm_delete_window);
         }
 
+        // Not tied to the window, left queued it would keep the loop awake.
+        while (XCheckTypedEvent(display, MappingNotify, &xevent))
+            XRefreshKeyboardMapping(&xevent.xmapping);
+
         if (!run)
             break;
 
+        if (!visible)
+            continue;
 
         uibase::Vec2i_t mouse_delta = uibase::vec2i_sub(layer_mediator->state_.mouse_pos,
                                                         layer_mediator->back_state_.mouse_pos);
@@ -408,14 +477,19 @@ int main(int __argc, char* __argv[])
         glXSwapBuffers(display, window);
 
         auto end = StdClock::now();
-        float measured_time = static_cast<float>(std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count());
+        float measured_time = std::chrono::duration<float, std::milli>(end-start).count();
         frame_time += measured_time;
         last_frame_time = measured_time / 1000.f;
         static int const kFrameInterval = 0xff;
         i = (i + 1) & kFrameInterval;
         if (!i)
         {
-            std::cout << "avg frame_time: " << (frame_time / float(kFrameInterval)) << std::endl;
+            appbase::FrameTimings const& gpu = layer_mediator->timings_;
+            std::cout << "avg frame_time: " << (frame_time / float(kFrameInterval + 1)) << " ms"
+                      << " (gpu sr " << gpu.shaderunner * 1000.f
+                      << ", gizmo " << gpu.gizmo * 1000.f
+                      << ", blit " << gpu.blit * 1000.f
+                      << ", imgui " << gpu.imgui * 1000.f << " ms)" << std::endl;
             frame_time = 0.f;
         }
     }